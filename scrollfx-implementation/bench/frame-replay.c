@@ -0,0 +1,549 @@
+/*
+ * Frame-loop replay.
+ *
+ * Plays back a log written by the replay_record command against a running
+ * compositor, usually a headless one started by headless-bench.sh. Every
+ * recorded view becomes an xdg-shell toplevel that commits shm buffers of the
+ * recorded sizes, damage and opaque regions, and acks configures where the
+ * recorded client did. Commands are sent over IPC. Events are paced by their
+ * recorded timestamps so that the compositor sees the same sequence.
+ *
+ * Input events cannot be injected into the headless backend; they are
+ * counted, and their effect on the layout is replayed through the commands
+ * that bindings ran.
+ */
+#define _POSIX_C_SOURCE 200809L
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include <wayland-client.h>
+#include "sway/replay.h"
+#include "xdg-shell-client-protocol.h"
+
+#define IPC_MAGIC "i3-ipc"
+#define IPC_RUN_COMMAND 0
+
+struct replay_client_view {
+	uint32_t id;
+	struct wl_surface *surface;
+	struct xdg_surface *xdg_surface;
+	struct xdg_toplevel *xdg_toplevel;
+	uint32_t configure_serial; // latest unacked configure, 0 if none
+	uint32_t frame; // commit counter, used to vary the buffer contents
+	struct wl_list link;
+};
+
+struct replay_event {
+	struct replay_event_header header;
+	uint64_t payload[UINT16_MAX / sizeof(uint64_t) + 1]; // aligned for doubles
+};
+
+struct replay_state {
+	struct wl_display *display;
+	struct wl_compositor *compositor;
+	struct wl_shm *shm;
+	struct xdg_wm_base *wm_base;
+	struct wl_list views; // replay_client_view::link
+	int ipc_fd;
+
+	uint64_t events, commits, configure_acks, commands;
+	uint64_t skipped_input, skipped_commands, late_events;
+	int64_t max_lateness_ns;
+};
+
+static int64_t now_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void wm_base_handle_ping(void *data, struct xdg_wm_base *wm_base,
+		uint32_t serial) {
+	xdg_wm_base_pong(wm_base, serial);
+}
+
+static const struct xdg_wm_base_listener wm_base_listener = {
+	.ping = wm_base_handle_ping,
+};
+
+static void registry_handle_global(void *data, struct wl_registry *registry,
+		uint32_t name, const char *interface, uint32_t version) {
+	struct replay_state *state = data;
+	if (strcmp(interface, wl_compositor_interface.name) == 0) {
+		state->compositor = wl_registry_bind(registry, name,
+			&wl_compositor_interface, 4);
+	} else if (strcmp(interface, wl_shm_interface.name) == 0) {
+		state->shm = wl_registry_bind(registry, name, &wl_shm_interface, 1);
+	} else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+		state->wm_base = wl_registry_bind(registry, name,
+			&xdg_wm_base_interface, 1);
+		xdg_wm_base_add_listener(state->wm_base, &wm_base_listener, state);
+	}
+}
+
+static void registry_handle_global_remove(void *data,
+		struct wl_registry *registry, uint32_t name) {
+	// Globals used here are not expected to go away
+}
+
+static const struct wl_registry_listener registry_listener = {
+	.global = registry_handle_global,
+	.global_remove = registry_handle_global_remove,
+};
+
+static void xdg_surface_handle_configure(void *data,
+		struct xdg_surface *xdg_surface, uint32_t serial) {
+	struct replay_client_view *view = data;
+	view->configure_serial = serial;
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+	.configure = xdg_surface_handle_configure,
+};
+
+static void toplevel_handle_configure(void *data,
+		struct xdg_toplevel *toplevel, int32_t width, int32_t height,
+		struct wl_array *states) {
+	// Sizes come from the log, not from the replayed compositor
+}
+
+static void toplevel_handle_close(void *data, struct xdg_toplevel *toplevel) {
+	// Views live as long as they did in the recording
+}
+
+static const struct xdg_toplevel_listener toplevel_listener = {
+	.configure = toplevel_handle_configure,
+	.close = toplevel_handle_close,
+};
+
+static void buffer_handle_release(void *data, struct wl_buffer *buffer) {
+	wl_buffer_destroy(buffer);
+}
+
+static const struct wl_buffer_listener buffer_listener = {
+	.release = buffer_handle_release,
+};
+
+static struct wl_buffer *create_buffer(struct replay_state *state,
+		int width, int height, uint32_t frame) {
+	int stride = width * 4;
+	size_t size = (size_t)stride * height;
+
+	char name[32];
+	int fd = -1;
+	for (int i = 0; i < 100 && fd < 0; ++i) {
+		snprintf(name, sizeof(name), "/frame-replay-%06x",
+			(unsigned)(now_nsec() + i) & 0xffffff);
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	}
+	if (fd < 0) {
+		perror("shm_open");
+		return NULL;
+	}
+	shm_unlink(name);
+	if (ftruncate(fd, size) < 0) {
+		perror("ftruncate");
+		close(fd);
+		return NULL;
+	}
+
+	uint32_t *pixels = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (pixels == MAP_FAILED) {
+		perror("mmap");
+		close(fd);
+		return NULL;
+	}
+	// Vary the color per frame so that every commit changes content
+	uint32_t color = 0xff000000 | ((frame * 0x10305) & 0xffffff);
+	for (size_t i = 0; i < size / 4; ++i) {
+		pixels[i] = color;
+	}
+	munmap(pixels, size);
+
+	struct wl_shm_pool *pool = wl_shm_create_pool(state->shm, fd, size);
+	struct wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0,
+		width, height, stride, WL_SHM_FORMAT_ARGB8888);
+	wl_shm_pool_destroy(pool);
+	close(fd);
+
+	wl_buffer_add_listener(buffer, &buffer_listener, NULL);
+	return buffer;
+}
+
+static struct replay_client_view *view_find(struct replay_state *state,
+		uint32_t id) {
+	struct replay_client_view *view;
+	wl_list_for_each(view, &state->views, link) {
+		if (view->id == id) {
+			return view;
+		}
+	}
+	return NULL;
+}
+
+static void view_map(struct replay_state *state,
+		const struct replay_view *event, const char *app_id, size_t app_id_len) {
+	struct replay_client_view *view = calloc(1, sizeof(*view));
+	if (!view) {
+		return;
+	}
+	view->id = event->view_id;
+	view->surface = wl_compositor_create_surface(state->compositor);
+	view->xdg_surface = xdg_wm_base_get_xdg_surface(state->wm_base,
+		view->surface);
+	xdg_surface_add_listener(view->xdg_surface, &xdg_surface_listener, view);
+	view->xdg_toplevel = xdg_surface_get_toplevel(view->xdg_surface);
+	xdg_toplevel_add_listener(view->xdg_toplevel, &toplevel_listener, view);
+
+	char *name = strndup(app_id, app_id_len);
+	if (name) {
+		xdg_toplevel_set_app_id(view->xdg_toplevel, name);
+		free(name);
+	}
+	wl_list_insert(&state->views, &view->link);
+
+	// The initial commit must be configured before the view can map
+	wl_surface_commit(view->surface);
+	while (view->configure_serial == 0 &&
+			wl_display_dispatch(state->display) != -1) {
+		// Wait for the initial configure
+	}
+	xdg_surface_ack_configure(view->xdg_surface, view->configure_serial);
+	view->configure_serial = 0;
+
+	int width = event->width > 0 ? event->width : 640;
+	int height = event->height > 0 ? event->height : 480;
+	struct wl_buffer *buffer = create_buffer(state, width, height, 0);
+	if (buffer) {
+		wl_surface_attach(view->surface, buffer, 0, 0);
+	}
+	wl_surface_commit(view->surface);
+}
+
+static void view_unmap(struct replay_client_view *view) {
+	xdg_toplevel_destroy(view->xdg_toplevel);
+	xdg_surface_destroy(view->xdg_surface);
+	wl_surface_destroy(view->surface);
+	wl_list_remove(&view->link);
+	free(view);
+}
+
+static void view_commit(struct replay_state *state,
+		struct replay_client_view *view, const struct replay_commit *event,
+		const struct replay_rect *rects, bool ack) {
+	if (ack && view->configure_serial) {
+		xdg_surface_ack_configure(view->xdg_surface, view->configure_serial);
+		view->configure_serial = 0;
+		state->configure_acks++;
+	}
+
+	if (event->width > 0 && event->height > 0) {
+		struct wl_buffer *buffer = create_buffer(state, event->width,
+			event->height, ++view->frame);
+		if (buffer) {
+			wl_surface_attach(view->surface, buffer, 0, 0);
+		}
+	}
+	for (int i = 0; i < event->damage_rects; ++i) {
+		wl_surface_damage_buffer(view->surface, rects[i].x, rects[i].y,
+			rects[i].width, rects[i].height);
+	}
+
+	struct wl_region *opaque = NULL;
+	if (event->opaque_rects > 0) {
+		opaque = wl_compositor_create_region(state->compositor);
+		for (int i = 0; i < event->opaque_rects; ++i) {
+			const struct replay_rect *rect = &rects[event->damage_rects + i];
+			wl_region_add(opaque, rect->x, rect->y, rect->width, rect->height);
+		}
+	}
+	wl_surface_set_opaque_region(view->surface, opaque);
+	if (opaque) {
+		wl_region_destroy(opaque);
+	}
+
+	wl_surface_commit(view->surface);
+	state->commits++;
+}
+
+static int ipc_connect(void) {
+	const char *path = getenv("SWAYSOCK");
+	if (!path) {
+		fprintf(stderr, "SWAYSOCK is not set, commands will be skipped\n");
+		return -1;
+	}
+
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		perror("socket");
+		return -1;
+	}
+	struct sockaddr_un addr = { .sun_family = AF_UNIX };
+	snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+		perror("connect");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+static bool read_full(int fd, void *buf, size_t len) {
+	while (len > 0) {
+		ssize_t n = read(fd, buf, len);
+		if (n <= 0) {
+			return false;
+		}
+		buf = (char *)buf + n;
+		len -= n;
+	}
+	return true;
+}
+
+// Returns true if any of the ';' or ',' separated commands is exec or
+// exec_always, which would spawn the recorded session's programs again
+static bool command_spawns(const char *command, size_t len) {
+	size_t i = 0;
+	while (i < len) {
+		while (i < len && (command[i] == ' ' || command[i] == '\t')) {
+			i++;
+		}
+		if (i < len && command[i] == '[') {
+			while (i < len && command[i] != ']') {
+				i++;
+			}
+			i++;
+			while (i < len && (command[i] == ' ' || command[i] == '\t')) {
+				i++;
+			}
+		}
+		size_t word = i;
+		while (i < len && command[i] != ' ' && command[i] != '\t' &&
+				command[i] != ';' && command[i] != ',') {
+			i++;
+		}
+		size_t word_len = i - word;
+		if ((word_len == strlen("exec") &&
+				strncmp(command + word, "exec", word_len) == 0) ||
+				(word_len == strlen("exec_always") &&
+				strncmp(command + word, "exec_always", word_len) == 0)) {
+			return true;
+		}
+		while (i < len && command[i] != ';' && command[i] != ',') {
+			i++;
+		}
+		i++;
+	}
+	return false;
+}
+
+static void ipc_run_command(struct replay_state *state, const char *command,
+		size_t len) {
+	if (state->ipc_fd < 0) {
+		return;
+	}
+	// Recording is controlled by whoever replays the log
+	if (len >= strlen("replay_record") &&
+			strncmp(command, "replay_record", strlen("replay_record")) == 0) {
+		return;
+	}
+	// The recorded clients are played back instead
+	if (command_spawns(command, len)) {
+		state->skipped_commands++;
+		return;
+	}
+
+	char header[14];
+	uint32_t payload_len = len, type = IPC_RUN_COMMAND;
+	memcpy(header, IPC_MAGIC, 6);
+	memcpy(header + 6, &payload_len, 4);
+	memcpy(header + 10, &type, 4);
+	if (write(state->ipc_fd, header, sizeof(header)) != sizeof(header) ||
+			write(state->ipc_fd, command, len) != (ssize_t)len) {
+		perror("write");
+		return;
+	}
+
+	// The reply also tells us that the command has been run
+	if (!read_full(state->ipc_fd, header, sizeof(header))) {
+		return;
+	}
+	memcpy(&payload_len, header + 6, 4);
+	char *reply = malloc(payload_len);
+	if (reply) {
+		read_full(state->ipc_fd, reply, payload_len);
+		free(reply);
+	}
+	state->commands++;
+}
+
+// Dispatch Wayland events until the given time
+static void wait_until(struct replay_state *state, int64_t target_ns) {
+	int fd = wl_display_get_fd(state->display);
+	while (true) {
+		wl_display_flush(state->display);
+		int64_t remaining = target_ns - now_nsec();
+		if (remaining <= 0) {
+			return;
+		}
+
+		struct pollfd pfd = { .fd = fd, .events = POLLIN };
+		int timeout = (remaining + 999999) / 1000000;
+		if (poll(&pfd, 1, timeout) > 0 &&
+				wl_display_dispatch(state->display) == -1) {
+			return;
+		}
+	}
+}
+
+static bool read_event(FILE *file, struct replay_event *event) {
+	if (fread(&event->header, sizeof(event->header), 1, file) != 1) {
+		return false;
+	}
+	return event->header.length == 0 ||
+		fread(event->payload, event->header.length, 1, file) == 1;
+}
+
+static void usage(const char *name) {
+	fprintf(stderr, "Usage: %s [-s <speed>] <log>\n"
+		"  -s <speed>  Playback speed factor (default: 1)\n", name);
+	exit(1);
+}
+
+int main(int argc, char **argv) {
+	double speed = 1.0;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:h")) != -1) {
+		switch (opt) {
+		case 's':
+			speed = strtod(optarg, NULL);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1 || speed <= 0) {
+		usage(argv[0]);
+	}
+
+	FILE *file = fopen(argv[optind], "rb");
+	if (!file) {
+		perror("fopen");
+		return 1;
+	}
+	char magic[REPLAY_MAGIC_LEN];
+	if (fread(magic, sizeof(magic), 1, file) != 1 ||
+			memcmp(magic, REPLAY_MAGIC, REPLAY_MAGIC_LEN) != 0) {
+		fprintf(stderr, "%s is not a replay log\n", argv[optind]);
+		return 1;
+	}
+
+	struct replay_state state = { .ipc_fd = ipc_connect() };
+	wl_list_init(&state.views);
+	state.display = wl_display_connect(NULL);
+	if (!state.display) {
+		fprintf(stderr, "Unable to connect to the Wayland display\n");
+		return 1;
+	}
+	struct wl_registry *registry = wl_display_get_registry(state.display);
+	wl_registry_add_listener(registry, &registry_listener, &state);
+	wl_display_roundtrip(state.display);
+	if (!state.compositor || !state.shm || !state.wm_base) {
+		fprintf(stderr, "Compositor lacks wl_compositor, wl_shm or xdg_wm_base\n");
+		return 1;
+	}
+
+	// A commit and the configure ack it carried are recorded back to back,
+	// so events are read one ahead
+	static struct replay_event event, next;
+	bool have_next = read_event(file, &next);
+
+	int64_t start = now_nsec();
+	int64_t target = start;
+	while (have_next) {
+		event = next;
+		have_next = read_event(file, &next);
+
+		target += event.header.delta_us * 1000 / speed;
+		wait_until(&state, target);
+		int64_t lateness = now_nsec() - target;
+		if (lateness > 1000000) {
+			state.late_events++;
+		}
+		if (lateness > state.max_lateness_ns) {
+			state.max_lateness_ns = lateness;
+		}
+		state.events++;
+
+		const struct replay_view *view_event = (void *)event.payload;
+		const struct replay_commit *commit = (void *)event.payload;
+		const struct replay_view *next_view = (void *)next.payload;
+		struct replay_client_view *view;
+		switch (event.header.type) {
+		case REPLAY_VIEW_MAP:
+			view_map(&state, view_event, (char *)(view_event + 1),
+				event.header.length - sizeof(*view_event));
+			break;
+		case REPLAY_VIEW_UNMAP:
+			view = view_find(&state, view_event->view_id);
+			if (view) {
+				view_unmap(view);
+			}
+			break;
+		case REPLAY_COMMIT:
+			view = view_find(&state, commit->view_id);
+			if (view) {
+				bool ack = have_next &&
+					next.header.type == REPLAY_CONFIGURE_ACK &&
+					next_view->view_id == view->id;
+				view_commit(&state, view, commit,
+					(const struct replay_rect *)(commit + 1), ack);
+			}
+			break;
+		case REPLAY_COMMAND:
+			ipc_run_command(&state, (char *)event.payload, event.header.length);
+			break;
+		case REPLAY_CONFIGURE:
+		case REPLAY_CONFIGURE_ACK:
+			// Driven by the replayed compositor and by REPLAY_COMMIT
+			break;
+		default:
+			state.skipped_input++;
+			break;
+		}
+	}
+	wl_display_roundtrip(state.display);
+	fclose(file);
+
+	printf("{\"events\":%" PRIu64 ",\"commits\":%" PRIu64
+		",\"configure_acks\":%" PRIu64 ",\"commands\":%" PRIu64
+		",\"skipped_input\":%" PRIu64 ",\"skipped_commands\":%" PRIu64
+		",\"late_events\":%" PRIu64
+		",\"max_lateness_ns\":%" PRId64 ",\"duration_ns\":%" PRId64 "}\n",
+		state.events, state.commits, state.configure_acks, state.commands,
+		state.skipped_input, state.skipped_commands, state.late_events,
+		state.max_lateness_ns,
+		now_nsec() - start);
+
+	struct replay_client_view *view, *tmp;
+	wl_list_for_each_safe(view, tmp, &state.views, link) {
+		view_unmap(view);
+	}
+	if (state.ipc_fd >= 0) {
+		close(state.ipc_fd);
+	}
+	wl_display_disconnect(state.display);
+	return 0;
+}
@@ -0,0 +1,294 @@
+#!/bin/bash
+# ScrollFX Headless Benchmark
+# Runs Scroll on the wlroots headless backend with synthetic clients, replays
+# a scripted command scenario and reports timings as JSON.
+
+set -e
+
+RED='\033[0;31m'
+GREEN='\033[0;32m'
+BLUE='\033[0;34m'
+NC='\033[0m'
+
+usage() {
+    echo "Usage: $0 [options] <scroll-binary> <scenario>"
+    echo "       $0 [options] -p <replay-log> <scroll-binary>"
+    echo ""
+    echo "Options:"
+    echo "  -n <count>      Number of synthetic clients (default: 8)"
+    echo "  -r <hz>         Headless output refresh rate, which paces client commits (default: 60)"
+    echo "  -c <command>    Client command (default: weston-simple-shm)"
+    echo "  -e <config>     Extra config file to include, e.g. to enable effects"
+    echo "  -R <renderer>   WLR_RENDERER to use: pixman or gles2 (default: pixman)"
+    echo "  -o <file>       Write results to <file> instead of stdout"
+    echo "  -p <log>        Play back a replay_record log with frame-replay instead"
+    echo "                  of spawning clients and running a scenario"
+    echo ""
+    echo "Scenarios live in $(dirname "$0")/scenarios. Each line is a command;"
+    echo "'repeat <n> <command>' runs it n times, 'loop <n>' ... 'end' runs the"
+    echo "lines in between n times and 'sleep <ms>' waits."
+    exit 1
+}
+
+CLIENTS=8
+RATE=60
+CLIENT_CMD="weston-simple-shm"
+EXTRA_CONFIG=""
+RENDERER="pixman"
+OUTPUT=""
+REPLAY_LOG=""
+
+while getopts "n:r:c:e:R:o:p:h" opt; do
+    case $opt in
+        n) CLIENTS="$OPTARG" ;;
+        r) RATE="$OPTARG" ;;
+        c) CLIENT_CMD="$OPTARG" ;;
+        e) EXTRA_CONFIG="$OPTARG" ;;
+        R) RENDERER="$OPTARG" ;;
+        o) OUTPUT="$OPTARG" ;;
+        p) REPLAY_LOG="$OPTARG" ;;
+        *) usage ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+if [ -n "$REPLAY_LOG" ]; then
+    if [ $# -ne 1 ]; then
+        usage
+    fi
+    # The log brings its own clients and commands
+    CLIENTS=0
+    SCENARIO="$REPLAY_LOG"
+elif [ $# -ne 2 ]; then
+    usage
+fi
+
+SCROLL="$1"
+if [ -z "$REPLAY_LOG" ]; then
+    SCENARIO="$2"
+fi
+if [ ! -f "$SCENARIO" ] && [ -f "$(dirname "$0")/scenarios/$SCENARIO" ]; then
+    SCENARIO="$(dirname "$0")/scenarios/$SCENARIO"
+fi
+
+for tool in jq "$SCROLL"; do
+    if ! command -v "$tool" >/dev/null 2>&1; then
+        echo -e "${RED}Error: $tool not found${NC}" >&2
+        exit 1
+    fi
+done
+
+if [ ! -f "$SCENARIO" ]; then
+    echo -e "${RED}Error: Scenario not found: $SCENARIO${NC}" >&2
+    exit 1
+fi
+
+MSG="$(dirname "$(command -v "$SCROLL")")/scrollmsg"
+if [ ! -x "$MSG" ]; then
+    MSG="scrollmsg"
+fi
+
+REPLAY="$(dirname "$(command -v "$SCROLL")")/frame-replay"
+if [ ! -x "$REPLAY" ]; then
+    REPLAY="frame-replay"
+fi
+if [ -n "$REPLAY_LOG" ] && ! command -v "$REPLAY" >/dev/null 2>&1; then
+    echo -e "${RED}Error: frame-replay not found${NC}" >&2
+    exit 1
+fi
+
+WORK_DIR="$(mktemp -d)"
+COMPOSITOR_PID=""
+cleanup() {
+    if [ -n "$COMPOSITOR_PID" ]; then
+        kill "$COMPOSITOR_PID" 2>/dev/null || true
+        wait "$COMPOSITOR_PID" 2>/dev/null || true
+    fi
+    rm -rf "$WORK_DIR"
+}
+trap cleanup EXIT
+
+now_ns() {
+    date +%s%N
+}
+
+msg() {
+    "$MSG" -s "$SWAYSOCK" "$@"
+}
+
+#################################################
+# START COMPOSITOR
+#################################################
+echo -e "${BLUE}=== Starting headless compositor ===${NC}" >&2
+
+cat > "$WORK_DIR/config" <<CONFIG
+output HEADLESS-1 mode 1920x1080@${RATE}Hz
+CONFIG
+if [ -n "$EXTRA_CONFIG" ]; then
+    echo "include $(realpath "$EXTRA_CONFIG")" >> "$WORK_DIR/config"
+fi
+
+export XDG_RUNTIME_DIR="$WORK_DIR"
+export SWAYSOCK="$WORK_DIR/ipc.sock"
+WLR_BACKENDS=headless WLR_RENDERER="$RENDERER" WLR_LIBINPUT_NO_DEVICES=1 \
+    "$SCROLL" -c "$WORK_DIR/config" > "$WORK_DIR/log" 2>&1 &
+COMPOSITOR_PID=$!
+
+for _ in $(seq 100); do
+    if [ -S "$SWAYSOCK" ]; then
+        break
+    fi
+    sleep 0.1
+done
+if [ ! -S "$SWAYSOCK" ]; then
+    echo -e "${RED}Error: Compositor did not start, see log:${NC}" >&2
+    cat "$WORK_DIR/log" >&2
+    exit 1
+fi
+
+#################################################
+# SPAWN CLIENTS
+#################################################
+echo -e "${BLUE}=== Spawning $CLIENTS clients ===${NC}" >&2
+
+for _ in $(seq "$CLIENTS"); do
+    msg exec "$CLIENT_CMD" > /dev/null
+done
+
+count_views() {
+    msg -t get_tree | jq '[.. | objects | select(.pid? != null and .type == "con")] | length'
+}
+for _ in $(seq 100); do
+    if [ "$(count_views)" -ge "$CLIENTS" ]; then
+        break
+    fi
+    sleep 0.1
+done
+echo -e "  ${GREEN}✓${NC} $(count_views) views mapped" >&2
+
+#################################################
+# REPLAY SCENARIO
+#################################################
+echo -e "${BLUE}=== Replaying $(basename "$SCENARIO") ===${NC}" >&2
+
+msg -t get_perf_stats > "$WORK_DIR/perf-before.json"
+START=$(now_ns)
+
+: > "$WORK_DIR/commands.jsonl"
+echo '{}' > "$WORK_DIR/replay.json"
+run_command() {
+    local begin end
+    begin=$(now_ns)
+    msg "$1" > /dev/null
+    end=$(now_ns)
+    jq -cn --arg cmd "$1" --argjson ns $((end - begin)) \
+        '{command: $cmd, latency_ns: $ns}' >> "$WORK_DIR/commands.jsonl"
+}
+
+if [ -n "$REPLAY_LOG" ]; then
+    WAYLAND_SOCKET_PATH=$(find "$WORK_DIR" -maxdepth 1 -name 'wayland-*' ! -name '*.lock' | head -n 1)
+    WAYLAND_DISPLAY="$(basename "$WAYLAND_SOCKET_PATH")" \
+        "$REPLAY" "$REPLAY_LOG" > "$WORK_DIR/replay.json"
+else
+    # Unroll 'loop <n>' ... 'end' blocks
+    expand_scenario() {
+        awk '
+            /^loop [0-9]+$/ { times = $2; body = ""; looping = 1; next }
+            /^end$/ && looping {
+                for (i = 0; i < times; i++) printf "%s", body
+                looping = 0
+                next
+            }
+            looping { body = body $0 "\n"; next }
+            { print }
+        ' "$1"
+    }
+
+    while IFS= read -r line || [ -n "$line" ]; do
+        case "$line" in
+            ''|'#'*) continue ;;
+            sleep\ *) sleep "$(echo "${line#sleep }" | awk '{ print $1 / 1000 }')" ;;
+            repeat\ *)
+                read -r _ times command <<< "$line"
+                for _ in $(seq "$times"); do
+                    run_command "$command"
+                done
+                ;;
+            *) run_command "$line" ;;
+        esac
+    done < <(expand_scenario "$SCENARIO")
+fi
+
+END=$(now_ns)
+msg -t get_perf_stats > "$WORK_DIR/perf-after.json"
+
+#################################################
+# REPORT
+#################################################
+read -r RSS_KB HWM_KB < <(awk '/^VmRSS/ { rss = $2 } /^VmHWM/ { hwm = $2 } \
+    END { print rss, hwm }' "/proc/$COMPOSITOR_PID/status")
+
+REPORT=$(jq -n \
+    --arg scenario "$(basename "$SCENARIO")" \
+    --arg renderer "$RENDERER" \
+    --argjson clients "$CLIENTS" \
+    --argjson rate "$RATE" \
+    --argjson duration_ns $((END - START)) \
+    --argjson rss_kb "$RSS_KB" \
+    --argjson hwm_kb "$HWM_KB" \
+    --slurpfile before "$WORK_DIR/perf-before.json" \
+    --slurpfile after "$WORK_DIR/perf-after.json" \
+    --slurpfile commands "$WORK_DIR/commands.jsonl" \
+    --slurpfile replay "$WORK_DIR/replay.json" \
+    '# Percentiles of the samples added to a histogram between the two
+    # snapshots, as the upper bound of the bucket holding them
+    def percentiles($a; $b):
+        ($a.buckets | with_entries(.value -= ($b.buckets[.key] // 0))
+            | to_entries | map({ le: (.key | tonumber), n: .value })
+            | map(select(.n > 0)) | sort_by(.le)) as $buckets |
+        ($buckets | map(.n) | add // 0) as $total |
+        def at($p):
+            if $total == 0 then 0 else
+                ([($total * $p / 100 | floor), 1] | max) as $rank |
+                first(foreach $buckets[] as $e (0; . + $e.n;
+                    if . >= $rank then $e.le else empty end))
+            end;
+        { frames: $total, p50_us: at(50), p95_us: at(95), p99_us: at(99) };
+    {
+        scenario: $scenario,
+        renderer: $renderer,
+        clients: $clients,
+        refresh_hz: $rate,
+        duration_ns: $duration_ns,
+        memory: { rss_kb: $rss_kb, peak_rss_kb: $hwm_kb },
+        commands: {
+            count: ($commands | length),
+            mean_latency_ns: (if ($commands | length) > 0
+                then ($commands | map(.latency_ns) | add / length) else 0 end),
+            max_latency_ns: ($commands | map(.latency_ns) | max // 0)
+        },
+        outputs: [range($after[0].outputs | length) as $i |
+            $after[0].outputs[$i] as $a |
+            ($before[0].outputs | map(select(.name == $a.name)) | .[0] // {}) as $b |
+            {
+                name: $a.name,
+                frames_rendered: ($a.frames_rendered - ($b.frames_rendered // 0)),
+                frames_skipped: ($a.frames_skipped - ($b.frames_skipped // 0)),
+                missed_deadlines: ($a.missed_deadlines - ($b.missed_deadlines // 0)),
+                direct_scanouts: ($a.direct_scanouts - ($b.direct_scanouts // 0)),
+                frame_cpu: percentiles($a.pre_render_us; $b.pre_render_us // {}),
+                frame_gpu: percentiles($a.render_us; $b.render_us // {})
+            }],
+        transaction_wait_ms: ($after[0].transaction_wait_ms | with_entries(
+            .value -= ($before[0].transaction_wait_ms[.key] // 0))),
+        scene_nodes: $after[0].scene_nodes,
+        textures: $after[0].textures,
+        texture_bytes: $after[0].texture_bytes
+    } + if $replay[0] == {} then {} else { replay: $replay[0] } end')
+
+if [ -n "$OUTPUT" ]; then
+    echo "$REPORT" > "$OUTPUT"
+    echo -e "  ${GREEN}✓${NC} Results written to $OUTPUT" >&2
+else
+    echo "$REPORT"
+fi
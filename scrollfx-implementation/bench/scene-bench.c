@@ -0,0 +1,256 @@
+/*
+ * Scene-graph microbenchmarks.
+ *
+ * scene.c is included directly so that its internal helpers can be timed in
+ * isolation. The scene is built from scene buffers backed by a dummy
+ * wlr_buffer, which is never read, and headless outputs, so no Wayland
+ * display or renderer is needed.
+ *
+ * Visibility calculation is turned off, as with
+ * SWAY_SCENE_DISABLE_VISIBILITY=1: it asks the layout whether the overview is
+ * shown, which needs the compositor's root and config. set_position therefore
+ * measures damage and output tracking without opaque-region culling, and
+ * render_list measures the damage intersection for every buffer without the
+ * black rect shortcut.
+ */
+#include "../sway/tree/scene/scene.c"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <wlr/backend/headless.h>
+#include <wlr/interfaces/wlr_buffer.h>
+#include "sway/server.h"
+
+// Provided by main.c in the compositor
+struct sway_server server = {0};
+struct sway_debug debug = {0};
+
+#define OUTPUT_WIDTH 1920
+#define OUTPUT_HEIGHT 1080
+#define WINDOW_WIDTH 640
+#define WINDOW_HEIGHT 1080
+
+enum bench_shape {
+	SHAPE_DEEP, // every buffer nested one tree deeper than the last
+	SHAPE_WIDE, // scroller workspaces with a long row of windows each
+	SHAPE_OUTPUTS, // windows spread over many outputs
+};
+
+static const char *shape_names[] = {
+	[SHAPE_DEEP] = "deep",
+	[SHAPE_WIDE] = "wide",
+	[SHAPE_OUTPUTS] = "outputs",
+};
+
+struct bench_scene {
+	struct sway_scene *scene;
+	struct wlr_backend *backend;
+	struct wlr_buffer buffer; // shared by every scene buffer
+	struct sway_scene_buffer **buffers;
+	int num_buffers;
+	int num_outputs;
+	int width; // extent of the layout covered by outputs
+};
+
+static int64_t now_nsec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return timespec_to_nsec(&ts);
+}
+
+static void add_outputs(struct bench_scene *bench, struct wl_event_loop *loop,
+		int count) {
+	bench->backend = wlr_headless_backend_create(loop);
+	for (int i = 0; i < count; ++i) {
+		struct wlr_output *output = wlr_headless_add_output(bench->backend,
+			OUTPUT_WIDTH, OUTPUT_HEIGHT);
+		struct sway_scene_output *scene_output =
+			sway_scene_output_create(bench->scene, output);
+		sway_scene_output_set_position(scene_output, i * OUTPUT_WIDTH, 0);
+	}
+	bench->num_outputs = count;
+	bench->width = count * OUTPUT_WIDTH;
+}
+
+static void dummy_buffer_destroy(struct wlr_buffer *buffer) {
+	// Embedded in struct bench_scene
+}
+
+static const struct wlr_buffer_impl dummy_buffer_impl = {
+	.destroy = dummy_buffer_destroy,
+};
+
+static struct sway_scene_buffer *add_window(struct bench_scene *bench,
+		struct sway_scene_tree *parent, int x, int y) {
+	struct sway_scene_buffer *buffer =
+		sway_scene_buffer_create(parent, &bench->buffer);
+	sway_scene_buffer_set_dest_size(buffer, WINDOW_WIDTH, WINDOW_HEIGHT);
+	sway_scene_node_set_position(&buffer->node, x, y);
+	return buffer;
+}
+
+static void bench_scene_init(struct bench_scene *bench, struct wl_event_loop *loop,
+		enum bench_shape shape, int count) {
+	*bench = (struct bench_scene){0};
+	bench->scene = sway_scene_create();
+	bench->scene->calculate_visibility = false;
+	wlr_buffer_init(&bench->buffer, &dummy_buffer_impl,
+		WINDOW_WIDTH, WINDOW_HEIGHT);
+	bench->buffers = calloc(count, sizeof(*bench->buffers));
+	bench->num_buffers = count;
+
+	add_outputs(bench, loop, shape == SHAPE_OUTPUTS ? 8 : 1);
+
+	struct sway_scene_tree *tree = &bench->scene->tree;
+	int per_workspace = count < 100 ? count : 100;
+	for (int i = 0; i < count; ++i) {
+		switch (shape) {
+		case SHAPE_DEEP:
+			tree = sway_scene_tree_create(tree);
+			bench->buffers[i] = add_window(bench, tree, i % 3, 0);
+			break;
+		case SHAPE_WIDE:
+			if (i % per_workspace == 0) {
+				tree = sway_scene_tree_create(&bench->scene->tree);
+			}
+			bench->buffers[i] = add_window(bench, tree,
+				(i % per_workspace) * WINDOW_WIDTH, 0);
+			break;
+		case SHAPE_OUTPUTS:
+			bench->buffers[i] = add_window(bench, tree,
+				(i * WINDOW_WIDTH) % bench->width, 0);
+			break;
+		}
+	}
+}
+
+static void bench_scene_finish(struct bench_scene *bench) {
+	sway_scene_node_destroy(&bench->scene->tree.node);
+	wlr_buffer_drop(&bench->buffer);
+	wlr_backend_destroy(bench->backend);
+	free(bench->buffers);
+}
+
+static void report(const char *shape, int count, const char *op,
+		int64_t nsec, int iterations) {
+	printf("{\"shape\":\"%s\",\"nodes\":%d,\"op\":\"%s\","
+		"\"iterations\":%d,\"ns_per_op\":%.1f}\n",
+		shape, count, op, iterations, (double)nsec / iterations);
+}
+
+static bool count_iterator(struct sway_scene_node *node, double sx, double sy,
+		void *data) {
+	(*(int *)data)++;
+	return false;
+}
+
+static void bench_node_at(struct bench_scene *bench, const char *shape,
+		int iterations) {
+	double nx, ny;
+	int64_t start = now_nsec();
+	for (int i = 0; i < iterations; ++i) {
+		sway_scene_node_at(&bench->scene->tree.node,
+			(i * 7919) % bench->width, (i * 104729) % OUTPUT_HEIGHT, &nx, &ny);
+	}
+	report(shape, bench->num_buffers, "node_at", now_nsec() - start, iterations);
+}
+
+static void bench_nodes_in_box(struct bench_scene *bench, const char *shape,
+		int iterations) {
+	struct wlr_box box = { .width = OUTPUT_WIDTH, .height = OUTPUT_HEIGHT };
+	int found = 0;
+	int64_t start = now_nsec();
+	for (int i = 0; i < iterations; ++i) {
+		box.x = (i * OUTPUT_WIDTH) % bench->width;
+		scene_nodes_in_box(&bench->scene->tree.node, &box,
+			count_iterator, &found);
+	}
+	report(shape, bench->num_buffers, "nodes_in_box", now_nsec() - start, iterations);
+}
+
+static void bench_set_position(struct bench_scene *bench, const char *shape,
+		int iterations) {
+	// Moving a node runs scene_node_update(), scene_update_region() and
+	// update_node_update_outputs() for everything under the damage
+	int64_t start = now_nsec();
+	for (int i = 0; i < iterations; ++i) {
+		struct sway_scene_node *node =
+			&bench->buffers[i % bench->num_buffers]->node;
+		sway_scene_node_set_position(node, node->x + (i % 2 ? -1 : 1), node->y);
+	}
+	report(shape, bench->num_buffers, "set_position", now_nsec() - start, iterations);
+}
+
+static void bench_update_outputs(struct bench_scene *bench, const char *shape,
+		int iterations) {
+	int64_t start = now_nsec();
+	for (int i = 0; i < iterations; ++i) {
+		update_node_update_outputs(&bench->buffers[i % bench->num_buffers]->node,
+			&bench->scene->outputs, NULL, NULL);
+	}
+	report(shape, bench->num_buffers, "update_node_update_outputs",
+		now_nsec() - start, iterations);
+}
+
+static void bench_render_list(struct bench_scene *bench, const char *shape,
+		int iterations) {
+	struct wl_array render_list;
+	wl_array_init(&render_list);
+	struct render_list_constructor_data list_con = {
+		.box = { .width = OUTPUT_WIDTH, .height = OUTPUT_HEIGHT },
+		.render_list = &render_list,
+		.calculate_visibility = bench->scene->calculate_visibility,
+	};
+
+	int64_t start = now_nsec();
+	for (int i = 0; i < iterations; ++i) {
+		list_con.box.x = (i * OUTPUT_WIDTH) % bench->width;
+		render_list.size = 0;
+		scene_nodes_in_box(&bench->scene->tree.node, &list_con.box,
+			construct_render_list_iterator, &list_con);
+	}
+	report(shape, bench->num_buffers, "render_list", now_nsec() - start, iterations);
+	wl_array_release(&render_list);
+}
+
+int main(int argc, char **argv) {
+	int iterations = 1000;
+	int max_nodes = 10000;
+
+	int c;
+	while ((c = getopt(argc, argv, "i:n:h")) != -1) {
+		switch (c) {
+		case 'i':
+			iterations = atoi(optarg);
+			break;
+		case 'n':
+			max_nodes = atoi(optarg);
+			break;
+		default:
+			fprintf(stderr, "Usage: %s [-i iterations] [-n max nodes]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	sway_log_init(SWAY_ERROR, NULL);
+	struct wl_event_loop *loop = wl_event_loop_create();
+
+	for (enum bench_shape shape = SHAPE_DEEP; shape <= SHAPE_OUTPUTS; ++shape) {
+		for (int count = 10; count <= max_nodes; count *= 10) {
+			struct bench_scene bench;
+			bench_scene_init(&bench, loop, shape, count);
+
+			const char *name = shape_names[shape];
+			bench_node_at(&bench, name, iterations);
+			bench_nodes_in_box(&bench, name, iterations);
+			bench_set_position(&bench, name, iterations);
+			bench_update_outputs(&bench, name, iterations);
+			bench_render_list(&bench, name, iterations);
+
+			bench_scene_finish(&bench);
+		}
+	}
+
+	wl_event_loop_destroy(loop);
+	return 0;
+}
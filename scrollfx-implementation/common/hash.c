@@ -0,0 +1,17 @@
+#include "hash.h"
+
+uint32_t fnv1a(uint32_t hash, const void *data, size_t len) {
+	const unsigned char *bytes = data;
+	for (size_t i = 0; i < len; ++i) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	return hash;
+}
+
+uint32_t fnv1a_str(const char *str) {
+	uint32_t hash = FNV1A_INIT;
+	for (; *str; ++str) {
+		hash = (hash ^ (unsigned char)*str) * 16777619u;
+	}
+	return hash;
+}
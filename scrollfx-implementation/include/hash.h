@@ -0,0 +1,19 @@
+#ifndef _SWAY_HASH_H
+#define _SWAY_HASH_H
+#include <stddef.h>
+#include <stdint.h>
+
+#define FNV1A_INIT 2166136261u
+
+/**
+ * 32-bit FNV-1a. Start with FNV1A_INIT and pass the result back in to hash
+ * data that arrives in pieces.
+ */
+uint32_t fnv1a(uint32_t hash, const void *data, size_t len);
+
+/**
+ * FNV-1a of a NUL-terminated string.
+ */
+uint32_t fnv1a_str(const char *str);
+
+#endif
@@ -59,6 +59,20 @@ const struct cmd_handler *find_handler(const char *line,
  */
 list_t *execute_command(char *command,  struct sway_seat *seat,
 		struct sway_container *con);
+/**
+ * Executes each command list of commands in order, as execute_command would on
+ * the focused container, and commits a single transaction for all of them.
+ *
+ * Returns a list with the cmd_results list of each command list, to be freed
+ * with free_command_batch_results.
+ */
+list_t *execute_command_batch(list_t *commands, struct sway_seat *seat);
+void free_command_batch_results(list_t *batch);
+/**
+ * Drop the parsed command lists that execute_command keeps for commands run
+ * at runtime. Needed whenever variables or the config change.
+ */
+void command_cache_invalidate(void);
 /**
  * Parse and handles a command during config file loading.
  *
@@ -88,6 +102,13 @@ void free_cmd_results(struct cmd_results *results);
  * Free the JSON string later on.
  */
 char *cmd_results_to_json(list_t *res_list);
+/**
+ * Serializes the result of execute_command_batch to a JSON array holding the
+ * result array of each command list.
+ *
+ * Free the JSON string later on.
+ */
+char *cmd_results_batch_to_json(list_t *batch);
 
 /**
  * Handlers shared by exec and exec_always.
@@ -119,10 +140,12 @@ sway_cmd cmd_client_pinned_focused;
 sway_cmd cmd_client_selected;
 sway_cmd cmd_client_selected_focused;
 sway_cmd cmd_commands;
+sway_cmd cmd_config_cache;
 sway_cmd cmd_create_output;
 sway_cmd cmd_cursor_shake_magnify;
 sway_cmd cmd_cycle_size;
 sway_cmd cmd_cycle_size_wrap;
+sway_cmd cmd_damage_heatmap;
 sway_cmd cmd_default_border;
 sway_cmd cmd_default_floating_border;
 sway_cmd cmd_default_orientation;
@@ -180,6 +203,7 @@ sway_cmd cmd_new_window;
 sway_cmd cmd_nop;
 sway_cmd cmd_no_focus;
 sway_cmd cmd_output;
+sway_cmd cmd_perf_hud;
 sway_cmd cmd_permit;
 sway_cmd cmd_pin;
 sway_cmd cmd_popup_during_fullscreen;
@@ -187,6 +211,8 @@ sway_cmd cmd_primary_selection;
 sway_cmd cmd_reject;
 sway_cmd cmd_reload;
 sway_cmd cmd_rename;
+sway_cmd cmd_render_profile;
+sway_cmd cmd_replay_record;
 sway_cmd cmd_resize;
 sway_cmd cmd_scale_content;
 sway_cmd cmd_scale_workspace;
@@ -213,6 +239,7 @@ sway_cmd cmd_title_format;
 sway_cmd cmd_titlebar_border_thickness;
 sway_cmd cmd_titlebar_padding;
 sway_cmd cmd_toggle_size;
+sway_cmd cmd_trace;
 sway_cmd cmd_trail;
 sway_cmd cmd_trailmark;
 sway_cmd cmd_unbindcode;
@@ -388,6 +415,8 @@ sway_cmd cmd_shadow_inactive_color;
 sway_cmd cmd_shadows;
 sway_cmd cmd_shadows_on_csd;
 
+sway_cmd cmd_effects_lod;
+sway_cmd cmd_effects_min_scale;
 sway_cmd cmd_layer_effects;
 sway_cmd cmd_opacity;
 sway_cmd cmd_titlebar_separator;
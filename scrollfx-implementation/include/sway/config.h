@@ -511,6 +511,22 @@ enum xwayland_mode {
 	XWAYLAND_MODE_IMMEDIATE,
 };
 
+/**
+ * Parts of the config that can change on reload, see config_diff().
+ */
+enum config_diff_part {
+	CONFIG_DIFF_BINDINGS = 1 << 0,
+	CONFIG_DIFF_OUTPUTS = 1 << 1,
+	CONFIG_DIFF_INPUTS = 1 << 2,
+	CONFIG_DIFF_SEATS = 1 << 3,
+	CONFIG_DIFF_COLORS = 1 << 4, // anything drawn into title bar textures
+	CONFIG_DIFF_EFFECTS = 1 << 5,
+	CONFIG_DIFF_LAYER_CRITERIA = 1 << 6,
+	CONFIG_DIFF_ANIMATIONS = 1 << 7,
+	CONFIG_DIFF_SWAYBG = 1 << 8, // swaybg_command and output backgrounds
+	CONFIG_DIFF_ALL = (1 << 9) - 1,
+};
+
 /**
  * The configuration struct. The result of loading a config file.
  */
@@ -556,6 +572,20 @@ struct sway_config {
 	bool titlebar_separator;
 	bool scratchpad_minimize;
 
+	// Adaptive effect quality during motion or when over the frame budget
+	struct {
+		bool enabled;
+		float threshold; // fraction of the refresh period
+		int hysteresis; // calm frames before restoring full quality
+		int blur_passes; // blur passes used while reduced
+	} effects_lod;
+
+	float effects_min_scale; // layout scale below which effects are skipped
+
+	bool perf_hud; // frame-timing overlay on every output
+	bool pointer_coalesce; // apply pointer motion once per output frame
+	bool config_cache; // keep compiled keymaps for the next start
+
 	list_t *layer_criteria;
 
 	uint32_t floating_mod;
@@ -595,6 +625,7 @@ struct sway_config {
 	bool reloading;
 	bool reading;
 	bool validating;
+	uint32_t reload_changes; // enum config_diff_part, set by the last load
 	bool auto_back_and_forth;
 	bool show_marks;
 	enum alignment title_align;
@@ -696,6 +727,13 @@ struct sway_config {
  */
 bool load_main_config(const char *path, bool is_active, bool validating);
 
+/**
+ * Compares two configs and returns the enum config_diff_part bits of the parts
+ * that differ, so a reload only applies those.
+ */
+uint32_t config_diff(struct sway_config *old_config,
+		struct sway_config *new_config);
+
 /**
  * Loads an included config. Can only be used after load_main_config.
  */
@@ -0,0 +1,41 @@
+#ifndef _SWAY_CONFIG_CACHE_H
+#define _SWAY_CONFIG_CACHE_H
+#include <stdint.h>
+#include <xkbcommon/xkbcommon.h>
+
+/**
+ * Cache of the keymaps compiled for keysym translation while loading the
+ * config. Compiling a keymap from rule names reads and parses dozens of XKB
+ * files, which is most of the time spent loading a config, while a cached
+ * keymap is parsed from a single string.
+ *
+ * The cache is written to $XDG_CACHE_HOME/scroll/config.cache when
+ * `config_cache enable` is set, and is only used while the config files and
+ * the XKB rules it was built from keep their mtime, size and hash, the
+ * files in the XKB include path keep their mtime and size, and xkbcommon
+ * keeps its version.
+ */
+
+struct sway_config;
+
+/**
+ * Reads the cache written by an earlier start. Only the first call reads it.
+ */
+void config_cache_load(void);
+
+/**
+ * Returns a keymap compiled earlier from the same names, or NULL.
+ */
+struct xkb_keymap *config_cache_get_keymap(struct xkb_context *context,
+		const struct xkb_rule_names *names, uint32_t context_flags);
+
+void config_cache_add_keymap(const struct xkb_rule_names *names,
+		uint32_t context_flags, struct xkb_keymap *keymap);
+
+/**
+ * Writes the cache for the files the config was read from if anything
+ * changed, or removes it if the config disables it.
+ */
+void config_cache_save(struct sway_config *config);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef _SWAY_CRITERIA_INDEX_H
+#define _SWAY_CRITERIA_INDEX_H
+#include "list.h"
+
+/**
+ * Index of mapped views by the string properties criteria match on, and of
+ * containers by mark. Each distinct value is stored once with the containers
+ * that have it, so a criteria pattern is run once per distinct value instead
+ * of once per container.
+ */
+enum criteria_index_field {
+	CRITERIA_INDEX_APP_ID,
+	CRITERIA_INDEX_CLASS,
+	CRITERIA_INDEX_INSTANCE,
+	CRITERIA_INDEX_SHELL,
+	CRITERIA_INDEX_MARK, // containers with or without a view
+	CRITERIA_INDEX_FIELD_COUNT,
+};
+
+// Fields with a single value per view
+#define CRITERIA_INDEX_VIEW_FIELDS CRITERIA_INDEX_MARK
+
+struct criteria;
+struct sway_container;
+struct sway_view;
+
+void criteria_index_add_view(struct sway_view *view);
+
+void criteria_index_remove_view(struct sway_view *view);
+
+/**
+ * Refile a view whose app_id, class or instance may have changed.
+ */
+void criteria_index_update_view(struct sway_view *view);
+
+void criteria_index_add_mark(struct sway_container *con, const char *mark);
+
+void criteria_index_remove_mark(struct sway_container *con, const char *mark);
+
+/**
+ * Returns the container with the mark, if any.
+ */
+struct sway_container *criteria_index_find_mark(const char *mark);
+
+/**
+ * Returns the containers that can match the criteria, or NULL if none of its
+ * patterns are indexed and every container has to be checked. Containers
+ * without a view are included. The caller frees the list and still has to
+ * check each candidate against the criteria.
+ */
+list_t *criteria_index_get_candidates(struct criteria *criteria);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef _SWAY_DAMAGE_HEATMAP_H
+#define _SWAY_DAMAGE_HEATMAP_H
+#include <pixman.h>
+#include <stdbool.h>
+
+struct wlr_box;
+struct wlr_output;
+struct wlr_scene_shadow;
+struct sway_scene_node;
+
+/**
+ * Records how often each part of every output is damaged, on a coarse grid,
+ * and which scene nodes the damage came from. Used to find clients and
+ * compositor features that damage more than they should.
+ */
+
+/**
+ * Start a new recording with a grid of columns x rows cells per output,
+ * discarding the previous one.
+ */
+void damage_heatmap_start(int columns, int rows);
+
+void damage_heatmap_stop(void);
+
+bool damage_heatmap_recording(void);
+
+/**
+ * Add the damage (in buffer coordinates) of a frame built for the output.
+ */
+void damage_heatmap_record_frame(struct wlr_output *output,
+	const pixman_region32_t *damage);
+
+/**
+ * Attribute damage to the scene node that caused it. area_scale converts the
+ * region's area into layout pixels.
+ */
+void damage_heatmap_record_source(struct sway_scene_node *node,
+	const pixman_region32_t *damage, double area_scale);
+
+/**
+ * Attribute damage added by an effect (e.g. "blur") on behalf of a scene
+ * node. It is reported as <effect>:<source name>.
+ */
+void damage_heatmap_record_effect(struct sway_scene_node *node,
+	const char *effect, const pixman_region32_t *damage, double area_scale);
+
+/**
+ * Attribute the area a shadow repaints to the node it is drawn for. Call
+ * before moving the shadow to box (in its parent's coordinates) and setting
+ * its color and blur sigma; nothing is recorded if none of them change.
+ */
+void damage_heatmap_record_shadow(struct sway_scene_node *node,
+	struct wlr_scene_shadow *shadow, const struct wlr_box *box,
+	const float color[static 4], float blur_sigma);
+
+/**
+ * Write <prefix>-<output>.pgm for every output and a <prefix>.json summary.
+ * Returns false if a file could not be written.
+ */
+bool damage_heatmap_export(const char *prefix);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef _SWAY_PERF_HUD_H
+#define _SWAY_PERF_HUD_H
+#include <stdbool.h>
+
+struct sway_output;
+
+/**
+ * Create or destroy the frame-timing overlay of an output according to
+ * config->perf_hud, and add a sample if the timings of a new frame were read
+ * back. Called once per repaint.
+ */
+void perf_hud_update(struct sway_output *output, bool new_frame);
+
+/**
+ * Destroy the output's frame-timing overlay, if any.
+ */
+void perf_hud_destroy(struct sway_output *output);
+
+#endif
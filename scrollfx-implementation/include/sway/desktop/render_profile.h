@@ -0,0 +1,57 @@
+#ifndef _SWAY_RENDER_PROFILE_H
+#define _SWAY_RENDER_PROFILE_H
+#include <stdbool.h>
+#include <stdint.h>
+
+struct json_object;
+struct wlr_output;
+struct sway_scene_node;
+
+/**
+ * Samples the cost of each render-list entry over a number of frames and
+ * attributes it to the window, layer surface or decoration that owns the
+ * entry, with blur and rounded-corner work broken out.
+ *
+ * CPU time is measured per entry. The GPU timer covers a whole render pass,
+ * so each frame's GPU time is split between its entries by rendered area.
+ */
+
+enum render_profile_kind {
+	RENDER_PROFILE_CONTENT,
+	RENDER_PROFILE_BLUR, // backdrop blur rects
+	RENDER_PROFILE_CORNERS, // rects with rounded corners
+	RENDER_PROFILE_KIND_COUNT,
+};
+
+/**
+ * Sample the next frames frames of every output, discarding the previous
+ * results.
+ */
+void render_profile_start(int frames);
+
+void render_profile_stop(void);
+
+/**
+ * Returns true if the frame being built for the output should be sampled.
+ * Entries are then passed to render_profile_record_entry() and the frame is
+ * closed with render_profile_frame_end().
+ */
+bool render_profile_frame_begin(struct wlr_output *output);
+
+void render_profile_record_entry(struct wlr_output *output,
+	struct sway_scene_node *node, int64_t cpu_ns, int64_t pixels);
+
+void render_profile_frame_end(struct wlr_output *output);
+
+/**
+ * Split the GPU time of the last frame sampled on the output between its
+ * entries. gpu_ns is -1 if the renderer has no timer.
+ */
+void render_profile_record_gpu(struct wlr_output *output, int64_t gpu_ns);
+
+/**
+ * Returns the per-output results, sources sorted by cost per frame.
+ */
+struct json_object *render_profile_get_json(void);
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef _SWAY_INPUT_POINTER_COALESCE_H
+#define _SWAY_INPUT_POINTER_COALESCE_H
+#include <stdbool.h>
+#include <stdint.h>
+#include "sway/input/refresh_throttle.h"
+
+struct wlr_cursor;
+struct wlr_input_device;
+struct pointer_coalesce;
+
+typedef void (*pointer_coalesce_apply_func_t)(struct pointer_coalesce *coalesce,
+	uint32_t time_msec, struct wlr_input_device *device, double dx, double dy);
+
+/**
+ * Coalesces accelerated pointer motion to one update per frame of the output
+ * under the cursor, when the pointer_coalesce option is enabled. Relative
+ * motion for relative-pointer clients is not part of this; the cursor code
+ * keeps sending it for every event.
+ */
+struct pointer_coalesce {
+	pointer_coalesce_apply_func_t apply;
+	struct refresh_throttle throttle;
+
+	uint32_t time_msec;
+	struct wlr_input_device *device;
+	double dx, dy;
+};
+
+void pointer_coalesce_init(struct pointer_coalesce *coalesce,
+	struct wlr_cursor *cursor, pointer_coalesce_apply_func_t apply);
+
+void pointer_coalesce_finish(struct pointer_coalesce *coalesce);
+
+/**
+ * Queue accelerated motion. Returns false if the caller should apply it now,
+ * either because coalescing is disabled or because no motion was applied
+ * during the current frame.
+ */
+bool pointer_coalesce_motion(struct pointer_coalesce *coalesce,
+	uint32_t time_msec, struct wlr_input_device *device, double dx, double dy);
+
+/**
+ * Apply queued motion now. Call before events that depend on the cursor
+ * position, such as buttons, axis events and warps.
+ */
+void pointer_coalesce_flush(struct pointer_coalesce *coalesce);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef _SWAY_INPUT_REFRESH_THROTTLE_H
+#define _SWAY_INPUT_REFRESH_THROTTLE_H
+#include <stdbool.h>
+#include <wayland-server-core.h>
+
+struct wlr_cursor;
+
+typedef void (*refresh_throttle_func_t)(void *data);
+
+/**
+ * Limits work triggered by pointer input to once per refresh period of the
+ * output under the cursor. The first request of a period runs right away;
+ * later ones are folded into a single call of func when the period ends.
+ */
+struct refresh_throttle {
+	struct wlr_cursor *cursor;
+	refresh_throttle_func_t func;
+	void *data;
+	struct wl_event_source *timer;
+	bool armed; // work ran during the current period
+	bool pending; // work is waiting for the period to end
+};
+
+/**
+ * Returns false if the timer could not be created. The throttle then lets
+ * every request run right away.
+ */
+bool refresh_throttle_init(struct refresh_throttle *throttle,
+	struct wlr_cursor *cursor, refresh_throttle_func_t func, void *data);
+
+void refresh_throttle_finish(struct refresh_throttle *throttle);
+
+/**
+ * Returns true if the caller should do the work now, starting a new period.
+ * Otherwise the work is pending until the period ends.
+ */
+bool refresh_throttle_request(struct refresh_throttle *throttle);
+
+/**
+ * Drops pending work. Returns true if there was any, for callers that do it
+ * themselves right away.
+ */
+bool refresh_throttle_cancel(struct refresh_throttle *throttle);
+
+/**
+ * Runs pending work now.
+ */
+void refresh_throttle_flush(struct refresh_throttle *throttle);
+
+#endif
@@ -27,8 +27,14 @@ void layer_criteria_destroy(struct layer_criteria *criteria);
 struct layer_criteria *layer_criteria_add(char *namespace, char *cmdlist);
 
 /**
- * Get the matching criteria for a specified namespace
+ * Get the last criteria added for a specified namespace
  */
 struct layer_criteria *layer_criteria_for_namespace(char *namespace);
 
+/**
+ * Apply the matching criteria, or the defaults, to every layer surface, or
+ * only to those with the given namespace if it isn't NULL
+ */
+void layer_criteria_apply(const char *namespace);
+
 #endif
@@ -0,0 +1,64 @@
+#ifndef _SWAY_MEM_STATS_H
+#define _SWAY_MEM_STATS_H
+#include <stddef.h>
+#include <wayland-server-core.h>
+
+/**
+ * Memory accounting per subsystem. Allocation sites tag what they allocate
+ * and free, and the current and peak bytes per tag are reported over IPC by
+ * get_mem_stats and written to the log on SIGUSR1.
+ */
+
+struct json_object;
+
+enum mem_tag {
+	MEM_CONTAINER,
+	MEM_SCENE_NODE,
+	MEM_REGION, // pixman region data of scene nodes, sampled on report
+	MEM_TEXT, // title and mark text buffers
+	MEM_SAVED_BUFFER, // saved surface snapshots of views in a transaction
+	MEM_TRANSACTION, // transactions and their instructions
+	MEM_LAYER_CRITERIA,
+	MEM_TEXTURE, // estimated at 4 bytes per pixel
+	MEM_TAG_COUNT,
+};
+
+struct mem_tag_stats {
+	int64_t bytes;
+	int64_t peak_bytes;
+	int64_t count; // live objects
+};
+
+extern struct mem_tag_stats mem_stats[MEM_TAG_COUNT];
+
+static inline void mem_account_alloc(enum mem_tag tag, size_t bytes) {
+	struct mem_tag_stats *stats = &mem_stats[tag];
+	stats->bytes += bytes;
+	stats->count++;
+	if (stats->bytes > stats->peak_bytes) {
+		stats->peak_bytes = stats->bytes;
+	}
+}
+
+static inline void mem_account_free(enum mem_tag tag, size_t bytes) {
+	mem_stats[tag].bytes -= bytes;
+	mem_stats[tag].count--;
+}
+
+/**
+ * Dump the stats to the log when the compositor receives SIGUSR1.
+ */
+void mem_stats_init(struct wl_event_loop *loop);
+
+/**
+ * Returns the per-tag stats as a JSON object, after sampling the tags that
+ * cannot be tracked at allocation time.
+ */
+struct json_object *mem_stats_get_json(void);
+
+/**
+ * Write the per-tag stats to the log.
+ */
+void mem_stats_dump(void);
+
+#endif
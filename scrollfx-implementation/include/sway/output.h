@@ -5,6 +5,7 @@
 #include <wayland-server-core.h>
 #include <wlr/types/wlr_damage_ring.h>
 #include <wlr/types/wlr_output.h>
+#include "sway/perf.h"
 #include "sway/tree/scene.h"
 #include "config.h"
 #include "sway/tree/node.h"
@@ -13,6 +14,7 @@
 
 struct sway_server;
 struct sway_container;
+struct perf_hud;
 
 struct sway_output_state {
 	list_t *workspaces;
@@ -76,6 +78,15 @@ struct sway_output {
 	struct wl_event_source *repaint_timer;
 	bool allow_tearing;
 
+	struct sway_scene_timer frame_timer; // duration of the last frame
+	struct perf_output_stats perf;
+	struct perf_hud *perf_hud; // frame-timing overlay, if enabled
+
+	struct {
+		bool reduced;
+		int calm_frames;
+	} effects_lod;
+
 	struct sway_scroller_output_options scroller_options;
 };
 
@@ -138,6 +149,23 @@ struct sway_container *output_find_container(struct sway_output *output,
 
 void output_get_box(struct sway_output *output, struct wlr_box *box);
 
+/**
+ * Returns true while any output renders effects at reduced quality, either
+ * because something is moving or because the last frame was over budget.
+ */
+bool output_effects_lod_reduced(void);
+
+/**
+ * Tells the effects LOD whether a layout animation is in progress.
+ */
+void output_effects_lod_set_animating(bool animating);
+
+/**
+ * Pushes the configured blur and shadow parameters to the scene, at reduced
+ * quality if output_effects_lod_reduced().
+ */
+void output_apply_effects(void);
+
 enum sway_container_layout output_get_default_layout(
 		struct sway_output *output);
 
@@ -0,0 +1,95 @@
+#ifndef _SWAY_PERF_H
+#define _SWAY_PERF_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Live compositor performance counters, reported over IPC by
+ * get_perf_stats and the perf_stats event.
+ */
+
+// Upper bounds (in ms) of the transaction wait histogram buckets. The last
+// bucket collects everything slower.
+#define PERF_TXN_WAIT_BUCKETS 8
+extern const int perf_txn_wait_bounds[PERF_TXN_WAIT_BUCKETS - 1];
+
+// Log-linear latency histogram in microseconds: each power of two is split
+// into 1 << PERF_HIST_SUB_BITS buckets, which bounds the relative error to
+// 12.5% over the whole range (up to about a minute).
+#define PERF_HIST_SUB_BITS 3
+#define PERF_HIST_BUCKETS 192
+
+struct perf_histogram {
+	uint64_t counts[PERF_HIST_BUCKETS];
+	uint64_t total;
+	int64_t max_us;
+};
+
+struct json_object;
+struct sway_scene_node;
+struct sway_view;
+
+struct perf_output_stats {
+	uint64_t frames_skipped; // repaints with nothing to draw
+	uint64_t missed_deadlines; // frames slower than the refresh period
+	int64_t pre_render_ns; // CPU time of the last frame
+	int64_t render_ns; // GPU time of the last frame, -1 if unknown
+	struct perf_histogram pre_render_hist; // CPU time of every frame
+	struct perf_histogram render_hist; // GPU time of every timed frame
+	bool timer_pending; // the frame timer holds an unread frame
+};
+
+struct perf_stats {
+	uint64_t txn_wait[PERF_TXN_WAIT_BUCKETS];
+	double last_txn_wait_ms;
+	struct perf_histogram txn_latency; // commit to apply
+	uint64_t txn_timeouts;
+};
+
+extern struct perf_stats perf_stats;
+
+/**
+ * Add a transaction's commit-to-apply time to the wait histogram.
+ */
+void perf_record_txn_wait(double ms);
+
+void perf_histogram_add(struct perf_histogram *hist, int64_t us);
+
+/**
+ * Returns the upper bound of the bucket holding the given percentile
+ * (0 to 100), or 0 if the histogram is empty.
+ */
+int64_t perf_histogram_percentile(const struct perf_histogram *hist,
+	double percentile);
+
+/**
+ * Add the time a view took to ack a configure to its client's histogram.
+ * Clients are grouped by app_id, or by class for X11 views.
+ */
+void perf_record_configure_ack(struct sway_view *view, int64_t us);
+
+/**
+ * Blame a view that had not acked its configure when a transaction timed out.
+ */
+void perf_record_configure_timeout(struct sway_view *view);
+
+/**
+ * Names what a scene node draws, to attribute costs to it: view:<app_id>,
+ * layer_shell, decoration:<node type> or other:<node type>.
+ */
+void perf_node_get_source_name(struct sway_scene_node *node,
+	char *name, size_t size);
+
+/**
+ * Returns the global and per-output counters as a JSON object.
+ */
+struct json_object *perf_stats_get_json(void);
+
+/**
+ * Returns the transaction latency summary and the clients with the most
+ * timeouts and the slowest configure acks, at most limit of them.
+ */
+struct json_object *perf_txn_blame_get_json(int limit);
+
+#endif
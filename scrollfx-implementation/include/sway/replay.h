@@ -0,0 +1,128 @@
+#ifndef _SWAY_REPLAY_H
+#define _SWAY_REPLAY_H
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Frame-loop capture. While recording, the inputs that drive the frame loop
+ * (views mapping, surface commits, configures and their acks, commands and
+ * input events) are appended to a compact binary log, which
+ * bench/frame-replay.c plays back against a headless compositor.
+ *
+ * The log starts with REPLAY_MAGIC, followed by events. Each event is a
+ * struct replay_event_header and length bytes of payload. Fields are in host
+ * byte order; logs are meant to be replayed on the machine type that
+ * recorded them.
+ */
+
+#define REPLAY_MAGIC "SFXRPLY1"
+#define REPLAY_MAGIC_LEN 8
+
+// Commits with more rectangles than this record their extents instead
+#define REPLAY_MAX_RECTS 16
+
+enum replay_event_type {
+	REPLAY_VIEW_MAP = 1, // struct replay_view + app_id
+	REPLAY_VIEW_UNMAP, // struct replay_view
+	REPLAY_COMMIT, // struct replay_commit + rects
+	REPLAY_CONFIGURE, // struct replay_view
+	REPLAY_CONFIGURE_ACK, // struct replay_view
+	REPLAY_COMMAND, // command string
+	REPLAY_POINTER_MOTION, // struct replay_pointer_motion
+	REPLAY_POINTER_BUTTON, // struct replay_input
+	REPLAY_POINTER_AXIS, // struct replay_pointer_axis
+	REPLAY_KEY, // struct replay_input
+};
+
+struct replay_event_header {
+	uint8_t type;
+	uint8_t reserved;
+	uint16_t length; // payload bytes following the header
+	uint32_t delta_us; // time since the previous event
+};
+
+struct replay_view {
+	uint32_t view_id;
+	int32_t width, height;
+	uint32_t xwayland;
+};
+
+struct replay_rect {
+	int32_t x, y, width, height;
+};
+
+struct replay_commit {
+	uint32_t view_id;
+	int32_t width, height;
+	uint16_t damage_rects; // buffer-local damage
+	uint16_t opaque_rects; // surface-local opaque region
+};
+
+struct replay_pointer_motion {
+	uint32_t time_msec;
+	uint32_t reserved;
+	double dx, dy;
+};
+
+struct replay_pointer_axis {
+	uint32_t time_msec;
+	uint32_t orientation;
+	double delta;
+	int32_t delta_discrete;
+	uint32_t reserved;
+};
+
+struct replay_input {
+	uint32_t time_msec;
+	uint32_t code; // button or keycode
+	uint32_t state;
+	uint32_t reserved;
+};
+
+struct sway_view;
+struct wlr_surface;
+
+/**
+ * Start recording to the file at path, replacing any recording in progress.
+ * Returns false if the file could not be opened.
+ */
+bool replay_record_start(const char *path);
+
+/**
+ * Finish the recording in progress, if any, and close its file.
+ */
+void replay_record_stop(void);
+
+bool replay_recording(void);
+
+void replay_record_view_map(struct sway_view *view);
+
+void replay_record_view_unmap(struct sway_view *view);
+
+/**
+ * Record a commit of the view's surface with its size, damage and opaque
+ * region.
+ */
+void replay_record_commit(struct sway_view *view, struct wlr_surface *surface);
+
+void replay_record_configure(struct sway_view *view, int width, int height);
+
+void replay_record_configure_ack(struct sway_view *view);
+
+/**
+ * Record a command that did not come from criteria, which the replayed
+ * compositor runs again by itself.
+ */
+void replay_record_command(const char *command);
+
+void replay_record_pointer_motion(uint32_t time_msec, double dx, double dy);
+
+void replay_record_pointer_button(uint32_t time_msec, uint32_t button,
+	uint32_t state);
+
+void replay_record_pointer_axis(uint32_t time_msec, uint32_t orientation,
+	double delta, int32_t delta_discrete);
+
+void replay_record_key(uint32_t time_msec, uint32_t keycode, uint32_t state);
+
+#endif
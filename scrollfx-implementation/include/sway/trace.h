@@ -0,0 +1,44 @@
+#ifndef _SWAY_TRACE_H
+#define _SWAY_TRACE_H
+#include <stdbool.h>
+
+/**
+ * Opt-in tracing of the frame and transaction pipeline. Events are written
+ * in the Chrome trace-event JSON format, which can be loaded in
+ * chrome://tracing or ui.perfetto.dev.
+ */
+
+/**
+ * Start writing trace events to the file at path, replacing any trace in
+ * progress. Returns false if the file could not be opened.
+ */
+bool trace_start(const char *path);
+
+/**
+ * Finish the trace in progress, if any, and close its file.
+ */
+void trace_stop(void);
+
+/**
+ * Returns true while a trace is being written. Callers that need to format
+ * span details should check this first.
+ */
+bool trace_enabled(void);
+
+/**
+ * Open a span. Spans nest and are closed in reverse order by trace_end().
+ * detail is an optional string shown in the span's arguments.
+ */
+void trace_begin(const char *name, const char *detail);
+
+/**
+ * Close the most recently opened span.
+ */
+void trace_end(void);
+
+/**
+ * Record an event without duration, such as a page flip.
+ */
+void trace_instant(const char *name, const char *detail);
+
+#endif
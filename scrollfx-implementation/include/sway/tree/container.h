@@ -4,6 +4,7 @@
 #include <sys/types.h>
 #include <wlr/types/wlr_compositor.h>
 #include "list.h"
+#include "sway/criteria_index.h"
 #include "sway/tree/scene.h"
 #include "sway/tree/node.h"
 
@@ -134,6 +135,9 @@ struct sway_container {
 
 	char *title_format;
 
+	// Values the view is filed under in the criteria index
+	char *index_keys[CRITERIA_INDEX_VIEW_FIELDS];
+
 	enum sway_container_layout prev_split_layout;
 
 	// Whether stickiness has been enabled on this container. Use
@@ -436,4 +440,16 @@ bool container_has_shadow(struct sway_container *con);
  */
 bool container_has_corner_radius(struct sway_container *con);
 
+/**
+ * Returns true if the container's current workspace is scaled down (overview
+ * or layout scale) below effects_min_scale. Shadows, blur, dimming and title
+ * text are skipped for such containers.
+ */
+bool container_effects_culled(struct sway_container *con);
+
+/**
+ * Returns the corner radius scaled by the workspace layout scale.
+ */
+int container_get_scaled_corner_radius(struct sway_container *con);
+
 #endif
@@ -76,6 +76,9 @@ struct sway_root {
 
 	struct sway_container *fullscreen_global;
 
+	// Bumped by root_tree_changed()
+	uint64_t tree_serial;
+
 	struct {
 		struct wl_signal new_node;
 	} events;
@@ -147,8 +150,35 @@ struct sway_workspace *root_find_workspace(
 struct sway_container *root_find_container(
 		bool (*test)(struct sway_container *con, void *data), void *data);
 
+/**
+ * Containers are indexed by id from creation to destruction, and views by
+ * PID while mapped, so these lookups do not walk the tree. Like
+ * root_find_container(), they skip containers that are being destroyed.
+ */
+void root_index_add_container(struct sway_container *con);
+
+void root_index_remove_container(struct sway_container *con);
+
+void root_index_add_view(struct sway_view *view);
+
+void root_index_remove_view(struct sway_view *view);
+
+struct sway_container *root_find_container_by_id(size_t id);
+
+/**
+ * Returns a mapped view of the process, if it has any.
+ */
+struct sway_view *root_find_view_by_pid(pid_t pid);
+
 void root_get_box(struct sway_root *root, struct wlr_box *box);
 
+/**
+ * Invalidates the state cached from the pending tree, such as workspace view
+ * counts. Call it wherever a container is added to or removed from a parent
+ * or workspace.
+ */
+void root_tree_changed(void);
+
 void root_set_default_filters(struct sway_root *root);
 
 #endif
@@ -62,6 +62,7 @@ struct sway_scene_node_info {
 	struct wlr_output *wlr_output;	// wlr_output the node belongs to (if tiled, otherwise NULL)
 	struct sway_workspace *workspace;
 	bool background;	// bakground layer shell, usually the wallpaper
+	bool blur_source;	// below the optimized blur layer, feeds the blur cache
 };
 
 /** A node is an object in the scene. */
@@ -136,6 +137,15 @@ struct sway_scene {
 		bool direct_scanout;
 		bool calculate_visibility;
 		bool highlight_transparent_region;
+
+		// How far (in logical pixels) a damaged pixel spreads through the
+		// backdrop blur kernel
+		int blur_kernel_size;
+
+		// Managed Xwayland surfaces in the stacking order last sent to the
+		// X server, top first, and the pending pass that updates it
+		struct wl_array xwayland_stack;
+		struct wl_event_source *xwayland_restack_idle;
 	};
 };
 
@@ -212,6 +222,12 @@ struct sway_scene_buffer {
 	enum wl_output_transform transform;
 	pixman_region32_t opaque_region;
 
+	// SceneFX effects, see wlr_scene_buffer_set_corner_radius() and
+	// wlr_scene_buffer_set_backdrop_blur()
+	int corner_radius;
+	enum corner_location corners;
+	bool backdrop_blur;
+
 	struct {
 		uint64_t active_outputs;
 		struct wlr_texture *texture;
@@ -250,6 +266,14 @@ struct sway_scene_output {
 		struct wl_signal destroy;
 	} events;
 
+	struct {
+		uint64_t frames; // frames rendered or scanned out
+		uint64_t direct_scanouts;
+		int render_list_len; // of the last frame
+		int64_t damaged_area; // of the last frame, in buffer pixels
+		pixman_box32_t damage_extents; // of the last frame
+	} stats;
+
 	struct {
 		pixman_region32_t pending_commit_damage;
 
@@ -273,6 +297,12 @@ struct sway_scene_output {
 
 		struct wl_list damage_highlight_regions;
 
+		/**
+		 * Damage (in buffer coordinates) of content below the optimized blur
+		 * layer since the last commit, expanded by the blur kernel size
+		 */
+		pixman_region32_t blur_damage;
+
 		struct wl_array render_list;
 
 		struct wlr_drm_syncobj_timeline *in_timeline;
@@ -383,6 +413,13 @@ void sway_scene_set_linux_dmabuf_v1(struct sway_scene *scene,
 void sway_scene_set_gamma_control_manager_v1(struct sway_scene *scene,
 	struct wlr_gamma_control_manager_v1 *gamma_control);
 
+/**
+ * Set the blur kernel size in logical pixels. Damage to nodes below the
+ * optimized blur layer is expanded by this amount, so that the frame repaints
+ * every blurred pixel the change reaches.
+ */
+void sway_scene_set_blur_kernel_size(struct sway_scene *scene, int size);
+
 /**
  * Add a node displaying nothing but its children.
  */
@@ -535,6 +572,14 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 void sway_scene_buffer_set_opaque_region(struct sway_scene_buffer *scene_buffer,
 	const pixman_region32_t *region);
 
+/**
+ * Compute the part of the buffer's visible region (in layout coordinates) that
+ * is not covered by its opaque region. This is where content below shows
+ * through, so it is the only area where backdrop blur has any effect.
+ */
+void sway_scene_buffer_get_translucent_region(struct sway_scene_buffer *scene_buffer,
+	pixman_region32_t *region);
+
 /**
  * Set the source rectangle describing the region of the buffer which will be
  * sampled to render this node. This allows cropping the buffer.
@@ -613,6 +658,14 @@ struct sway_scene_output_state_options {
  */
 bool sway_scene_output_needs_frame(struct sway_scene_output *scene_output);
 
+/**
+ * Returns the damage (in buffer coordinates) below the optimized blur layer
+ * since the last committed frame, or NULL if there was none. SceneFX can only
+ * re-blur the whole layer, so any damage makes the cached background stale.
+ */
+const pixman_region32_t *sway_scene_output_get_blur_damage(
+	struct sway_scene_output *scene_output);
+
 /**
  * Render and commit an output.
  */
@@ -81,18 +81,30 @@ copy_file() {
 #################################################
 echo -e "${BLUE}=== Copying Header Files ===${NC}"
 
+copy_file "$IMPL_DIR/include/hash.h" "include/hash.h"
 copy_file "$IMPL_DIR/include/sway/commands.h" "include/sway/commands.h"
+copy_file "$IMPL_DIR/include/sway/desktop/damage_heatmap.h" "include/sway/desktop/damage_heatmap.h"
+copy_file "$IMPL_DIR/include/sway/desktop/perf_hud.h" "include/sway/desktop/perf_hud.h"
+copy_file "$IMPL_DIR/include/sway/desktop/render_profile.h" "include/sway/desktop/render_profile.h"
 copy_file "$IMPL_DIR/include/sway/config.h" "include/sway/config.h"
+copy_file "$IMPL_DIR/include/sway/config_cache.h" "include/sway/config_cache.h"
+copy_file "$IMPL_DIR/include/sway/criteria_index.h" "include/sway/criteria_index.h"
+copy_file "$IMPL_DIR/include/sway/input/pointer_coalesce.h" "include/sway/input/pointer_coalesce.h"
+copy_file "$IMPL_DIR/include/sway/input/refresh_throttle.h" "include/sway/input/refresh_throttle.h"
 copy_file "$IMPL_DIR/include/sway/layer_criteria.h" "include/sway/layer_criteria.h"
 copy_file "$IMPL_DIR/include/sway/layers.h" "include/sway/layers.h"
 copy_file "$IMPL_DIR/include/sway/output.h" "include/sway/output.h"
+copy_file "$IMPL_DIR/include/sway/mem_stats.h" "include/sway/mem_stats.h"
+copy_file "$IMPL_DIR/include/sway/perf.h" "include/sway/perf.h"
+copy_file "$IMPL_DIR/include/sway/replay.h" "include/sway/replay.h"
+copy_file "$IMPL_DIR/include/sway/trace.h" "include/sway/trace.h"
 
 copy_file "$IMPL_DIR/include/sway/tree/container.h" "include/sway/tree/container.h"
 copy_file "$IMPL_DIR/include/sway/tree/node.h" "include/sway/tree/node.h"
 copy_file "$IMPL_DIR/include/sway/tree/root.h" "include/sway/tree/root.h"
 copy_file "$IMPL_DIR/include/sway/tree/scene.h" "include/sway/tree/scene.h"
 
-git add include/sway/ 2>/dev/null || true
+git add include/hash.h include/sway/ 2>/dev/null || true
 
 echo ""
 
@@ -101,11 +113,19 @@ echo ""
 #################################################
 echo -e "${BLUE}=== Copying Core Source Files ===${NC}"
 
+copy_file "$IMPL_DIR/common/hash.c" "common/hash.c"
 copy_file "$IMPL_DIR/sway/commands.c" "sway/commands.c"
 copy_file "$IMPL_DIR/sway/config.c" "sway/config.c"
+copy_file "$IMPL_DIR/sway/config_cache.c" "sway/config_cache.c"
+copy_file "$IMPL_DIR/sway/config_diff.c" "sway/config_diff.c"
+copy_file "$IMPL_DIR/sway/criteria_index.c" "sway/criteria_index.c"
 copy_file "$IMPL_DIR/sway/layer_criteria.c" "sway/layer_criteria.c"
+copy_file "$IMPL_DIR/sway/mem_stats.c" "sway/mem_stats.c"
+copy_file "$IMPL_DIR/sway/perf.c" "sway/perf.c"
+copy_file "$IMPL_DIR/sway/replay.c" "sway/replay.c"
+copy_file "$IMPL_DIR/sway/trace.c" "sway/trace.c"
 
-git add sway/commands.c sway/config.c sway/layer_criteria.c 2>/dev/null || true
+git add common/hash.c sway/commands.c sway/config.c sway/config_cache.c sway/config_diff.c sway/criteria_index.c sway/layer_criteria.c sway/mem_stats.c sway/perf.c sway/replay.c sway/trace.c 2>/dev/null || true
 
 echo ""
 
@@ -154,6 +174,9 @@ copy_file "$IMPL_DIR/sway/desktop/transaction.c" "sway/desktop/transaction.c"
 copy_file "$IMPL_DIR/sway/desktop/layer_shell.c" "sway/desktop/layer_shell.c"
 copy_file "$IMPL_DIR/sway/desktop/xdg_shell.c" "sway/desktop/xdg_shell.c"
 copy_file "$IMPL_DIR/sway/desktop/xwayland.c" "sway/desktop/xwayland.c"
+copy_file "$IMPL_DIR/sway/desktop/damage_heatmap.c" "sway/desktop/damage_heatmap.c"
+copy_file "$IMPL_DIR/sway/desktop/perf_hud.c" "sway/desktop/perf_hud.c"
+copy_file "$IMPL_DIR/sway/desktop/render_profile.c" "sway/desktop/render_profile.c"
 
 git add sway/desktop/ 2>/dev/null || true
 
@@ -164,6 +187,8 @@ echo ""
 #################################################
 echo -e "${BLUE}=== Copying Input Handling Files ===${NC}"
 
+copy_file "$IMPL_DIR/sway/input/pointer_coalesce.c" "sway/input/pointer_coalesce.c"
+copy_file "$IMPL_DIR/sway/input/refresh_throttle.c" "sway/input/refresh_throttle.c"
 copy_file "$IMPL_DIR/sway/input/seatop_move_tiling.c" "sway/input/seatop_move_tiling.c"
 
 git add sway/input/ 2>/dev/null || true
@@ -1,5 +1,6 @@
 #include <ctype.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
@@ -8,9 +9,12 @@
 #include "sway/commands.h"
 #include "sway/config.h"
 #include "sway/criteria.h"
+#include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
+#include "sway/replay.h"
 #include "sway/tree/view.h"
+#include "hash.h"
 #include "stringop.h"
 #include "log.h"
 
@@ -74,6 +78,8 @@ static const struct cmd_handler handlers[] = {
 	{ "dim_inactive", cmd_dim_inactive },
 	{ "dim_inactive_colors.unfocused", cmd_dim_inactive_colors_unfocused },
 	{ "dim_inactive_colors.urgent", cmd_dim_inactive_colors_urgent },
+	{ "effects_lod", cmd_effects_lod },
+	{ "effects_min_scale", cmd_effects_min_scale },
 	{ "exec", cmd_exec },
 	{ "exec_always", cmd_exec_always },
 	{ "floating_maximum_size", cmd_floating_maximum_size },
@@ -100,6 +106,7 @@ static const struct cmd_handler handlers[] = {
 	{ "new_window", cmd_new_window },
 	{ "no_focus", cmd_no_focus },
 	{ "output", cmd_output },
+	{ "perf_hud", cmd_perf_hud },
 	{ "popup_during_fullscreen", cmd_popup_during_fullscreen },
 	{ "scratchpad_minimize", cmd_scratchpad_minimize },
 	{ "seat", cmd_seat },
@@ -134,6 +141,7 @@ static const struct cmd_handler handlers[] = {
 static const struct cmd_handler config_handlers[] = {
 	{ "align_reset_auto", cmd_align_reset_auto },
 	{ "animations", cmd_animations },
+	{ "config_cache", cmd_config_cache },
 	{ "cursor_shake_magnify", cmd_cursor_shake_magnify },
 	{ "cycle_size_wrap", cmd_cycle_size_wrap },
 	{ "default_orientation", cmd_default_orientation },
@@ -167,6 +175,7 @@ static const struct cmd_handler command_handlers[] = {
 	{ "border", cmd_border },
 	{ "create_output", cmd_create_output },
 	{ "cycle_size", cmd_cycle_size },
+	{ "damage_heatmap", cmd_damage_heatmap },
 	{ "exit", cmd_exit },
 	{ "fit_size", cmd_fit_size },
 	{ "floating", cmd_floating },
@@ -183,6 +192,8 @@ static const struct cmd_handler command_handlers[] = {
 	{ "pin", cmd_pin },
 	{ "reload", cmd_reload },
 	{ "rename", cmd_rename },
+	{ "render_profile", cmd_render_profile },
+	{ "replay_record", cmd_replay_record },
 	{ "resize", cmd_resize },
 	{ "scale_content", cmd_scale_content },
 	{ "scale_workspace", cmd_scale_workspace },
@@ -196,6 +207,7 @@ static const struct cmd_handler command_handlers[] = {
 	{ "swap", cmd_swap },
 	{ "title_format", cmd_title_format },
 	{ "toggle_size", cmd_toggle_size },
+	{ "trace", cmd_trace },
 	{ "trail", cmd_trail },
 	{ "trailmark", cmd_trailmark },
 	{ "unmark", cmd_unmark },
@@ -262,6 +274,263 @@ static void set_config_node(struct sway_node *node, bool node_overridden) {
 	}
 }
 
+// Runs a command on the focused node or on each container matched by
+// criteria, adding its result to res_list. Returns false if the rest of the
+// command list must not run.
+static bool run_command(const struct cmd_handler *handler, int argc, char **argv,
+		struct sway_seat *seat, struct sway_container *con,
+		bool using_criteria, list_t *containers, list_t *res_list) {
+	if (!using_criteria) {
+		if (con) {
+			set_config_node(&con->node, true);
+		} else {
+			set_config_node(seat_get_focus_inactive(seat, &root->node),
+					false);
+		}
+		struct cmd_results *res = handler->handle(argc-1, argv+1);
+		list_add(res_list, res);
+		return res->status != CMD_INVALID;
+	}
+
+	if (containers->length == 0) {
+		list_add(res_list,
+				cmd_results_new(CMD_FAILURE, "No matching node."));
+		return true;
+	}
+
+	struct cmd_results *fail_res = NULL;
+	for (int i = 0; i < containers->length; ++i) {
+		struct sway_container *container = containers->items[i];
+		set_config_node(&container->node, true);
+		struct cmd_results *res = handler->handle(argc-1, argv+1);
+		if (res->status == CMD_SUCCESS) {
+			free_cmd_results(res);
+		} else {
+			// last failure will take precedence
+			if (fail_res) {
+				free_cmd_results(fail_res);
+			}
+			fail_res = res;
+			if (res->status == CMD_INVALID) {
+				list_add(res_list, fail_res);
+				return false;
+			}
+		}
+	}
+	list_add(res_list,
+			fail_res ? fail_res : cmd_results_new(CMD_SUCCESS, NULL));
+	return true;
+}
+
+// A command of a command list, parsed with its variables replaced
+struct compiled_command {
+	const struct cmd_handler *handler; // NULL for an empty command
+	char *text;
+	int argc;
+	size_t args_size;
+	char *args; // argc packed NUL-terminated arguments
+};
+
+struct compiled_command_list {
+	char *exec;
+	uint32_t hash;
+	uint64_t last_used;
+	int refs; // the cache and each execution in progress
+	list_t *commands; // struct compiled_command *
+};
+
+// Command lists without criteria run at runtime, by bindings and IPC
+// clients. Dropped when a variable is set or the config is reloaded.
+#define COMMAND_CACHE_SIZE 64
+static struct compiled_command_list *command_cache[COMMAND_CACHE_SIZE];
+static uint64_t command_cache_clock = 0;
+
+static void compiled_command_list_unref(struct compiled_command_list *list) {
+	if (!list || --list->refs > 0) {
+		return;
+	}
+	for (int i = 0; i < list->commands->length; ++i) {
+		struct compiled_command *command = list->commands->items[i];
+		free(command->text);
+		free(command->args);
+		free(command);
+	}
+	list_free(list->commands);
+	free(list->exec);
+	free(list);
+}
+
+void command_cache_invalidate(void) {
+	for (int i = 0; i < COMMAND_CACHE_SIZE; ++i) {
+		compiled_command_list_unref(command_cache[i]);
+		command_cache[i] = NULL;
+	}
+}
+
+// Packs argv into command, leaving argv to the caller
+static bool compiled_command_set_args(struct compiled_command *command,
+		int argc, char **argv) {
+	command->argc = argc;
+	command->args_size = 0;
+	for (int i = 0; i < argc; ++i) {
+		command->args_size += strlen(argv[i]) + 1;
+	}
+	command->args = malloc(command->args_size);
+	if (!command->args) {
+		return false;
+	}
+	char *arg = command->args;
+	for (int i = 0; i < argc; ++i) {
+		size_t size = strlen(argv[i]) + 1;
+		memcpy(arg, argv[i], size);
+		arg += size;
+	}
+	return true;
+}
+
+// Parses a command list the way execute_command does. Returns NULL if any
+// part of it is invalid, leaving the error to execute_command, if it sets a
+// variable or if it has criteria.
+static struct compiled_command_list *compile_command_list(const char *_exec) {
+	// Criteria resolve values such as con_id=__focused__ when they are
+	// parsed, so they are parsed again on every run. This also skips lists
+	// that only have a '[' in an argument, which is harmless.
+	if (strchr(_exec, '[')) {
+		return NULL;
+	}
+
+	struct compiled_command_list *list = calloc(1, sizeof(*list));
+	char *exec = strdup(_exec);
+	if (!list || !exec || !(list->exec = strdup(_exec)) ||
+			!(list->commands = create_list())) {
+		goto error;
+	}
+	list->refs = 1;
+	list->hash = fnv1a_str(_exec);
+
+	char *head = exec;
+	char matched_delim = ';';
+	do {
+		struct compiled_command *command = calloc(1, sizeof(*command));
+		if (!command) {
+			goto error;
+		}
+		list_add(list->commands, command);
+
+		for (; isspace(*head); ++head) {}
+		char *cmd = argsep(&head, ";,", &matched_delim);
+		for (; isspace(*cmd); ++cmd) {}
+		if (!(command->text = strdup(cmd))) {
+			goto error;
+		}
+		if (strcmp(cmd, "") == 0) {
+			continue;
+		}
+
+		int argc;
+		char **argv = split_args(cmd, &argc);
+		if (strcmp(argv[0], "exec") != 0 &&
+				strcmp(argv[0], "exec_always") != 0 &&
+				strcmp(argv[0], "mode") != 0) {
+			for (int i = 1; i < argc; ++i) {
+				if (*argv[i] == '\"' || *argv[i] == '\'') {
+					strip_quotes(argv[i]);
+				}
+			}
+		}
+		command->handler = find_core_handler(argv[0]);
+		if (!command->handler || command->handler->handle == cmd_set) {
+			// Commands after a set must see the new value of the variable
+			free_argv(argc, argv);
+			goto error;
+		}
+		for (int i = 1; i < argc; ++i) {
+			argv[i] = do_var_replacement(argv[i]);
+		}
+		bool packed = compiled_command_set_args(command, argc, argv);
+		free_argv(argc, argv);
+		if (!packed) {
+			goto error;
+		}
+	} while (head);
+
+	free(exec);
+	return list;
+
+error:
+	free(exec);
+	if (list && list->commands) {
+		compiled_command_list_unref(list);
+	} else if (list) {
+		free(list->exec);
+		free(list);
+	}
+	return NULL;
+}
+
+// Returns a reference to the compiled form of exec, or NULL if it cannot be
+// compiled
+static struct compiled_command_list *command_cache_get(const char *exec) {
+	uint32_t hash = fnv1a_str(exec);
+	int slot = 0;
+	for (int i = 0; i < COMMAND_CACHE_SIZE; ++i) {
+		struct compiled_command_list *list = command_cache[i];
+		if (list && list->hash == hash && strcmp(list->exec, exec) == 0) {
+			list->last_used = ++command_cache_clock;
+			list->refs++;
+			return list;
+		}
+		// Fill empty slots first, then evict the least recently used
+		if (command_cache[slot] && (!list ||
+				list->last_used < command_cache[slot]->last_used)) {
+			slot = i;
+		}
+	}
+
+	struct compiled_command_list *list = compile_command_list(exec);
+	if (!list) {
+		return NULL;
+	}
+	compiled_command_list_unref(command_cache[slot]);
+	command_cache[slot] = list;
+	list->last_used = ++command_cache_clock;
+	list->refs++;
+	return list;
+}
+
+static void execute_compiled_command_list(struct compiled_command_list *list,
+		struct sway_seat *seat, struct sway_container *con, list_t *res_list) {
+	for (int i = 0; i < list->commands->length; ++i) {
+		struct compiled_command *command = list->commands->items[i];
+		if (!command->handler) {
+			sway_log(SWAY_INFO, "Ignoring empty command.");
+			continue;
+		}
+		sway_log(SWAY_INFO, "Handling command '%s'", command->text);
+
+		// Handlers may modify their arguments, so run them on a copy
+		char **argv = malloc(command->argc * sizeof(char *) + command->args_size);
+		if (!argv) {
+			list_add(res_list, cmd_results_new(CMD_FAILURE,
+					"Unable to allocate command arguments"));
+			break;
+		}
+		char *arg = (char *)(argv + command->argc);
+		memcpy(arg, command->args, command->args_size);
+		for (int j = 0; j < command->argc; ++j) {
+			argv[j] = arg;
+			arg += strlen(arg) + 1;
+		}
+
+		bool keep_going = run_command(command->handler, command->argc, argv,
+				seat, con, false, NULL, res_list);
+		free(argv);
+		if (!keep_going) {
+			break;
+		}
+	}
+}
+
 list_t *execute_command(char *_exec, struct sway_seat *seat,
 		struct sway_container *con) {
 	char *cmd;
@@ -277,16 +546,35 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 		}
 	}
 
-	char *exec = strdup(_exec);
-	char *head = exec;
 	list_t *res_list = create_list();
-
-	if (!res_list || !exec) {
+	if (!res_list) {
 		return NULL;
 	}
 
 	config->handler_context.seat = seat;
 
+	// Commands run by criteria are run again by the replayed compositor
+	if (!con) {
+		replay_record_command(_exec);
+	}
+
+	// Handlers are looked up in different tables while the config is read
+	if (config->active && !config->reading) {
+		struct compiled_command_list *compiled = command_cache_get(_exec);
+		if (compiled) {
+			execute_compiled_command_list(compiled, seat, con, res_list);
+			compiled_command_list_unref(compiled);
+			return res_list;
+		}
+	}
+
+	char *exec = strdup(_exec);
+	char *head = exec;
+	if (!exec) {
+		list_free(res_list);
+		return NULL;
+	}
+
 	do {
 		for (; isspace(*head); ++head) {}
 		// Extract criteria (valid for this command list only).
@@ -344,48 +632,15 @@ list_t *execute_command(char *_exec, struct sway_seat *seat,
 			argv[i] = do_var_replacement(argv[i]);
 		}
 
-
-		if (!using_criteria) {
-			if (con) {
-				set_config_node(&con->node, true);
-			} else {
-				set_config_node(seat_get_focus_inactive(seat, &root->node),
-						false);
-			}
-			struct cmd_results *res = handler->handle(argc-1, argv+1);
-			list_add(res_list, res);
-			if (res->status == CMD_INVALID) {
-				free_argv(argc, argv);
-				goto cleanup;
-			}
-		} else if (containers->length == 0) {
-			list_add(res_list,
-					cmd_results_new(CMD_FAILURE, "No matching node."));
-		} else {
-			struct cmd_results *fail_res = NULL;
-			for (int i = 0; i < containers->length; ++i) {
-				struct sway_container *container = containers->items[i];
-				set_config_node(&container->node, true);
-				struct cmd_results *res = handler->handle(argc-1, argv+1);
-				if (res->status == CMD_SUCCESS) {
-					free_cmd_results(res);
-				} else {
-					// last failure will take precedence
-					if (fail_res) {
-						free_cmd_results(fail_res);
-					}
-					fail_res = res;
-					if (res->status == CMD_INVALID) {
-						list_add(res_list, fail_res);
-						free_argv(argc, argv);
-						goto cleanup;
-					}
-				}
-			}
-			list_add(res_list,
-					fail_res ? fail_res : cmd_results_new(CMD_SUCCESS, NULL));
+		bool keep_going = run_command(handler, argc, argv, seat, con,
+				using_criteria, containers, res_list);
+		if (handler->handle == cmd_set) {
+			command_cache_invalidate();
 		}
 		free_argv(argc, argv);
+		if (!keep_going) {
+			goto cleanup;
+		}
 	} while(head);
 cleanup:
 	free(exec);
@@ -393,6 +648,39 @@ cleanup:
 	return res_list;
 }
 
+list_t *execute_command_batch(list_t *commands, struct sway_seat *seat) {
+	list_t *batch = create_list();
+	if (!batch) {
+		return NULL;
+	}
+
+	// Handlers that commit on their own are held to the single commit below
+	transaction_defer_begin();
+	for (int i = 0; i < commands->length; ++i) {
+		list_t *res_list = execute_command(commands->items[i], seat, NULL);
+		if (!res_list) {
+			res_list = create_list();
+			list_add(res_list, cmd_results_new(CMD_FAILURE,
+					"Unable to run command"));
+		}
+		list_add(batch, res_list);
+	}
+	transaction_commit_dirty();
+	transaction_defer_end();
+	return batch;
+}
+
+void free_command_batch_results(list_t *batch) {
+	for (int i = 0; i < batch->length; ++i) {
+		list_t *res_list = batch->items[i];
+		for (int j = 0; j < res_list->length; ++j) {
+			free_cmd_results(res_list->items[j]);
+		}
+		list_free(res_list);
+	}
+	list_free(batch);
+}
+
 // this is like execute_command above, except:
 // 1) it ignores empty commands (empty lines)
 // 2) it does variable substitution
@@ -484,6 +772,9 @@ struct cmd_results *config_command(char *exec, char **new_block) {
 
 	// Run command
 	results = handler->handle(argc - 1, argv + 1);
+	if (handler->handle == cmd_set) {
+		command_cache_invalidate();
+	}
 
 cleanup:
 	free_argv(argc, argv);
@@ -566,7 +857,7 @@ void free_cmd_results(struct cmd_results *results) {
 	free(results);
 }
 
-char *cmd_results_to_json(list_t *res_list) {
+static json_object *cmd_results_to_json_object(list_t *res_list) {
 	json_object *result_array = json_object_new_array();
 	for (int i = 0; i < res_list->length; ++i) {
 		struct cmd_results *results = res_list->items[i];
@@ -581,8 +872,25 @@ char *cmd_results_to_json(list_t *res_list) {
 		}
 		json_object_array_add(result_array, root);
 	}
+	return result_array;
+}
+
+char *cmd_results_to_json(list_t *res_list) {
+	json_object *result_array = cmd_results_to_json_object(res_list);
 	const char *json = json_object_to_json_string(result_array);
 	char *res = strdup(json);
 	json_object_put(result_array);
 	return res;
 }
+
+char *cmd_results_batch_to_json(list_t *batch) {
+	json_object *batch_array = json_object_new_array();
+	for (int i = 0; i < batch->length; ++i) {
+		json_object_array_add(batch_array,
+				cmd_results_to_json_object(batch->items[i]));
+	}
+	const char *json = json_object_to_json_string(batch_array);
+	char *res = strdup(json);
+	json_object_put(batch_array);
+	return res;
+}
@@ -1,5 +1,6 @@
 #include "sway/commands.h"
-#include "sway/tree/root.h"
+#include "sway/config.h"
+#include "sway/output.h"
 
 struct cmd_results *cmd_blur_passes(int argc, char **argv) {
 	struct cmd_results *error = NULL;
@@ -13,10 +14,10 @@ struct cmd_results *cmd_blur_passes(int argc, char **argv) {
 		return cmd_results_new(CMD_FAILURE, "Invalid number of passes (must be between 0 and 10)");
 	}
 
-	struct wlr_scene *root_scene = root->root_scene;
-	struct blur_data blur_data = root_scene->blur_data;
-	blur_data.num_passes = value;
-	wlr_scene_set_blur_data(root_scene, blur_data);
+	config->blur_data.num_passes = value;
+	if (!config->reloading) {
+		output_apply_effects();
+	}
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
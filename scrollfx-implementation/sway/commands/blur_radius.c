@@ -1,5 +1,6 @@
 #include "sway/commands.h"
-#include "sway/tree/root.h"
+#include "sway/config.h"
+#include "sway/output.h"
 
 struct cmd_results *cmd_blur_radius(int argc, char **argv) {
 	struct cmd_results *error = NULL;
@@ -13,8 +14,10 @@ struct cmd_results *cmd_blur_radius(int argc, char **argv) {
 		return cmd_results_new(CMD_FAILURE, "Invalid radius (must be between 0 and 10)");
 	}
 
-	struct wlr_scene *root_scene = root->root_scene;
-	wlr_scene_set_blur_radius(root_scene, value);
+	config->blur_data.radius = value;
+	if (!config->reloading) {
+		output_apply_effects();
+	}
 
 	return cmd_results_new(CMD_SUCCESS, NULL);
 }
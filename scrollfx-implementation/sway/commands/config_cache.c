@@ -0,0 +1,18 @@
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "util.h"
+
+// config_cache enable|disable|toggle
+struct cmd_results *cmd_config_cache(int argc, char **argv) {
+	struct cmd_results *error =
+		checkarg(argc, "config_cache", EXPECTED_EQUAL_TO, 1);
+
+	if (error) {
+		return error;
+	}
+
+	// Written or removed once the config is loaded, used from the next start
+	config->config_cache = parse_boolean(argv[0], config->config_cache);
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
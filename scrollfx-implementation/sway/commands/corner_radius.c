@@ -33,7 +33,8 @@ struct cmd_results *cmd_corner_radius(int argc, char **argv) {
 
 	config->corner_radius = value;
 
-	if (!config->handler_context.container) {
+	// A reload only resets containers if the default changed
+	if (!config->handler_context.container && !config->reloading) {
 		root_for_each_container(arrange_corner_radius_iter, NULL);
 		arrange_root();
 	}
@@ -0,0 +1,48 @@
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/desktop/damage_heatmap.h"
+
+// damage_heatmap start [<columns> <rows>]
+// damage_heatmap stop
+// damage_heatmap export <path prefix>
+struct cmd_results *cmd_damage_heatmap(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "damage_heatmap", EXPECTED_AT_LEAST, 1);
+
+	if (error) {
+		return error;
+	}
+
+	if (strcasecmp(argv[0], "start") == 0) {
+		int columns = 64, rows = 36;
+		if (argc == 3) {
+			char *inv_columns, *inv_rows;
+			columns = strtol(argv[1], &inv_columns, 10);
+			rows = strtol(argv[2], &inv_rows, 10);
+			if (*inv_columns != '\0' || *inv_rows != '\0' ||
+					columns < 1 || columns > 1024 || rows < 1 || rows > 1024) {
+				return cmd_results_new(CMD_INVALID,
+					"Grid size must be between 1 and 1024 cells per axis");
+			}
+		} else if (argc != 1) {
+			return cmd_results_new(CMD_INVALID,
+				"Expected 'damage_heatmap start [<columns> <rows>]'");
+		}
+		damage_heatmap_start(columns, rows);
+	} else if (strcasecmp(argv[0], "stop") == 0) {
+		damage_heatmap_stop();
+	} else if (strcasecmp(argv[0], "export") == 0) {
+		if ((error = checkarg(argc, "damage_heatmap", EXPECTED_EQUAL_TO, 2))) {
+			return error;
+		}
+		if (!damage_heatmap_export(argv[1])) {
+			return cmd_results_new(CMD_FAILURE,
+				"Unable to export damage heatmap to '%s'", argv[1]);
+		}
+	} else {
+		return cmd_results_new(CMD_INVALID,
+			"Expected 'damage_heatmap <start|stop|export> [<args>]'");
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
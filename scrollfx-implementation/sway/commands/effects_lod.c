@@ -0,0 +1,57 @@
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "util.h"
+
+// effects_lod enable|disable|toggle
+// effects_lod threshold <percent of the refresh budget>
+// effects_lod hysteresis <frames>
+// effects_lod blur_passes <passes>
+struct cmd_results *cmd_effects_lod(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "effects_lod", EXPECTED_AT_LEAST, 1);
+
+	if (error) {
+		return error;
+	}
+
+	if (argc == 1) {
+		config->effects_lod.enabled =
+			parse_boolean(argv[0], config->effects_lod.enabled);
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+
+	if ((error = checkarg(argc, "effects_lod", EXPECTED_EQUAL_TO, 2))) {
+		return error;
+	}
+
+	char *inv;
+	int value = strtol(argv[1], &inv, 10);
+	if (*inv != '\0') {
+		return cmd_results_new(CMD_INVALID, "Invalid value '%s'", argv[1]);
+	}
+
+	if (strcasecmp(argv[0], "threshold") == 0) {
+		if (value < 1 || value > 100) {
+			return cmd_results_new(CMD_INVALID,
+				"Threshold must be between 1 and 100 percent");
+		}
+		config->effects_lod.threshold = value / 100.0f;
+	} else if (strcasecmp(argv[0], "hysteresis") == 0) {
+		if (value < 0 || value > 1000) {
+			return cmd_results_new(CMD_INVALID,
+				"Hysteresis must be between 0 and 1000 frames");
+		}
+		config->effects_lod.hysteresis = value;
+	} else if (strcasecmp(argv[0], "blur_passes") == 0) {
+		if (value < 0 || value > 10) {
+			return cmd_results_new(CMD_INVALID,
+				"Invalid number of passes (must be between 0 and 10)");
+		}
+		config->effects_lod.blur_passes = value;
+	} else {
+		return cmd_results_new(CMD_INVALID, "Expected 'effects_lod "
+			"<enable|disable|toggle|threshold|hysteresis|blur_passes> [<value>]'");
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
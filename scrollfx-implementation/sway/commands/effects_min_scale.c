@@ -0,0 +1,26 @@
+#include <stdlib.h>
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "sway/tree/arrange.h"
+#include "util.h"
+
+// effects_min_scale <percent of the layout scale>
+struct cmd_results *cmd_effects_min_scale(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "effects_min_scale", EXPECTED_EQUAL_TO, 1);
+
+	if (error) {
+		return error;
+	}
+
+	char *inv;
+	int value = strtol(argv[0], &inv, 10);
+	if (*inv != '\0' || value < 0 || value > 100) {
+		return cmd_results_new(CMD_INVALID,
+			"Minimum scale must be between 0 and 100 percent");
+	}
+
+	config->effects_min_scale = value / 100.0f;
+
+	arrange_root();
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
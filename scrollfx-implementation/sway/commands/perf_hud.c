@@ -0,0 +1,28 @@
+#include "sway/commands.h"
+#include "sway/config.h"
+#include "sway/desktop/perf_hud.h"
+#include "sway/output.h"
+#include "sway/tree/root.h"
+#include "util.h"
+
+// perf_hud enable|disable|toggle
+struct cmd_results *cmd_perf_hud(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "perf_hud", EXPECTED_EQUAL_TO, 1);
+
+	if (error) {
+		return error;
+	}
+
+	config->perf_hud = parse_boolean(argv[0], config->perf_hud);
+
+	// The overlay is created on the next repaint of each output
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		if (!config->perf_hud) {
+			perf_hud_destroy(output);
+		}
+		wlr_output_schedule_frame(output->wlr_output);
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -0,0 +1,37 @@
+#include <stdlib.h>
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/desktop/render_profile.h"
+
+// render_profile start [<frames>]
+// render_profile stop
+struct cmd_results *cmd_render_profile(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "render_profile", EXPECTED_AT_LEAST, 1);
+
+	if (error) {
+		return error;
+	}
+
+	if (strcasecmp(argv[0], "start") == 0) {
+		int frames = 300;
+		if (argc == 2) {
+			char *inv;
+			frames = strtol(argv[1], &inv, 10);
+			if (*inv != '\0' || frames < 1) {
+				return cmd_results_new(CMD_INVALID,
+					"Expected a positive number of frames");
+			}
+		} else if (argc != 1) {
+			return cmd_results_new(CMD_INVALID,
+				"Expected 'render_profile start [<frames>]'");
+		}
+		render_profile_start(frames);
+	} else if (strcasecmp(argv[0], "stop") == 0) {
+		render_profile_stop();
+	} else {
+		return cmd_results_new(CMD_INVALID,
+			"Expected 'render_profile <start|stop> [<frames>]'");
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -0,0 +1,24 @@
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/replay.h"
+
+// replay_record <file>|disable
+struct cmd_results *cmd_replay_record(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "replay_record", EXPECTED_EQUAL_TO, 1);
+
+	if (error) {
+		return error;
+	}
+
+	if (strcasecmp(argv[0], "disable") == 0) {
+		replay_record_stop();
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+
+	if (!replay_record_start(argv[0])) {
+		return cmd_results_new(CMD_FAILURE,
+			"Unable to open replay log '%s'", argv[0]);
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
@@ -0,0 +1,24 @@
+#include <strings.h>
+#include "sway/commands.h"
+#include "sway/trace.h"
+
+// trace <file>|disable
+struct cmd_results *cmd_trace(int argc, char **argv) {
+	struct cmd_results *error = checkarg(argc, "trace", EXPECTED_EQUAL_TO, 1);
+
+	if (error) {
+		return error;
+	}
+
+	if (strcasecmp(argv[0], "disable") == 0) {
+		trace_stop();
+		return cmd_results_new(CMD_SUCCESS, NULL);
+	}
+
+	if (!trace_start(argv[0])) {
+		return cmd_results_new(CMD_FAILURE,
+			"Unable to open trace file '%s'", argv[0]);
+	}
+
+	return cmd_results_new(CMD_SUCCESS, NULL);
+}
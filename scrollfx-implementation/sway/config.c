@@ -21,8 +21,11 @@
 #include "sway/input/switch.h"
 #include "sway/commands.h"
 #include "sway/config.h"
+#include "sway/config_cache.h"
 #include "sway/criteria.h"
 #include "sway/desktop/transaction.h"
+#include "sway/layer_criteria.h"
+#include "sway/output.h"
 #include "sway/server.h"
 #include "sway/swaynag.h"
 #include "sway/tree/arrange.h"
@@ -40,10 +43,17 @@ struct sway_config *config = NULL;
 static struct xkb_state *keysym_translation_state_create(
 		struct xkb_rule_names rules, uint32_t context_flags) {
 	struct xkb_context *context = xkb_context_new(context_flags | XKB_CONTEXT_NO_SECURE_GETENV);
-	struct xkb_keymap *xkb_keymap = xkb_keymap_new_from_names(
-		context,
-		&rules,
-		XKB_KEYMAP_COMPILE_NO_FLAGS);
+	struct xkb_keymap *xkb_keymap =
+		config_cache_get_keymap(context, &rules, context_flags);
+	if (xkb_keymap == NULL) {
+		xkb_keymap = xkb_keymap_new_from_names(
+			context,
+			&rules,
+			XKB_KEYMAP_COMPILE_NO_FLAGS);
+		if (xkb_keymap != NULL) {
+			config_cache_add_keymap(&rules, context_flags, xkb_keymap);
+		}
+	}
 	xkb_context_unref(context);
 	if (xkb_keymap == NULL) {
 		sway_log(SWAY_ERROR, "Failed to compile keysym translation XKB keymap");
@@ -382,7 +392,8 @@ static void config_defaults(struct sway_config *config) {
 
 	config->blur_enabled = false;
 	config->blur_xray = false;
-	// blur_data is initialized by SceneFX via wlr_scene_set_blur_data
+	// Mirrors the SceneFX blur parameters, kept in sync by the blur_* commands
+	config->blur_data = blur_data_get_default();
 
 	config->shadow_enabled = false;
 	config->shadows_on_csd_enabled = true;
@@ -395,6 +406,15 @@ static void config_defaults(struct sway_config *config) {
 	config->titlebar_separator = false;
 	config->scratchpad_minimize = false;
 
+	config->effects_lod.enabled = false;
+	config->effects_lod.threshold = 0.75f;
+	config->effects_lod.hysteresis = 10;
+	config->effects_lod.blur_passes = 1;
+	config->effects_min_scale = 0.0f;
+	config->perf_hud = false;
+	config->pointer_coalesce = false;
+	config->config_cache = false;
+
 	if (!(config->layer_criteria = create_list())) goto cleanup;
 
 	// floating view
@@ -602,6 +622,23 @@ static bool load_config(const char *path, struct sway_config *config,
 	return config->active || !config->validating || config_load_success;
 }
 
+// Keeps the running swaybg when a reload did not change any background
+static void take_swaybg_client(struct sway_config *old_config) {
+	config->swaybg_client = old_config->swaybg_client;
+	config->swaybg_client_destroy.notify =
+		old_config->swaybg_client_destroy.notify;
+	wl_list_remove(&old_config->swaybg_client_destroy.link);
+	wl_list_init(&old_config->swaybg_client_destroy.link);
+	old_config->swaybg_client = NULL;
+	wl_client_add_destroy_listener(config->swaybg_client,
+		&config->swaybg_client_destroy);
+}
+
+static void reset_corner_radius_iterator(struct sway_container *con,
+		void *data) {
+	con->corner_radius = config->corner_radius;
+}
+
 bool load_main_config(const char *file, bool is_active, bool validating) {
 	char *path;
 	if (file != NULL) {
@@ -621,11 +658,15 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 		return false;
 	}
 
+	// Before config_defaults, which compiles the default keymap
+	config_cache_load();
+
 	struct sway_config *old_config = config;
 	config = calloc(1, sizeof(struct sway_config));
 	if (!config) {
 		sway_abort("Unable to allocate config");
 	}
+	command_cache_invalidate();
 
 	config_defaults(config);
 	config->validating = validating;
@@ -646,15 +687,9 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 		config->primary_selection = old_config->primary_selection;
 
 		if (!config->validating) {
-			if (old_config->swaybg_client != NULL) {
-				wl_client_destroy(old_config->swaybg_client);
-			}
-
 			if (old_config->swaynag_config_errors.client != NULL) {
 				wl_client_destroy(old_config->swaynag_config_errors.client);
 			}
-
-			input_manager_reset_all_inputs();
 		}
 	}
 
@@ -676,27 +711,60 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 	config_update_font_height();
 
 	if (!validating) {
+		// A reload only applies the parts of the config that changed
+		config->reload_changes = is_active ?
+			config_diff(old_config, config) : CONFIG_DIFF_ALL;
+		uint32_t changes = config->reload_changes;
+
 		input_manager_verify_fallback_seat();
 
-		for (int i = 0; i < config->input_configs->length; i++) {
-			input_manager_apply_input_config(config->input_configs->items[i]);
-		}
+		if (changes & CONFIG_DIFF_INPUTS) {
+			if (is_active) {
+				input_manager_reset_all_inputs();
+			}
 
-		for (int i = 0; i < config->input_type_configs->length; i++) {
-			input_manager_apply_input_config(
-					config->input_type_configs->items[i]);
+			for (int i = 0; i < config->input_configs->length; i++) {
+				input_manager_apply_input_config(config->input_configs->items[i]);
+			}
+
+			for (int i = 0; i < config->input_type_configs->length; i++) {
+				input_manager_apply_input_config(
+						config->input_type_configs->items[i]);
+			}
 		}
 
-		for (int i = 0; i < config->seat_configs->length; i++) {
-			input_manager_apply_seat_config(config->seat_configs->items[i]);
+		// Resetting inputs also resets their seat attachments
+		if (changes & (CONFIG_DIFF_INPUTS | CONFIG_DIFF_SEATS)) {
+			for (int i = 0; i < config->seat_configs->length; i++) {
+				input_manager_apply_seat_config(config->seat_configs->items[i]);
+			}
 		}
 		sway_switch_retrigger_bindings_for_all();
 
-		spawn_swaybg();
+		if (is_active && !(changes & CONFIG_DIFF_SWAYBG) &&
+				old_config->swaybg_client != NULL) {
+			take_swaybg_client(old_config);
+		} else {
+			if (is_active && old_config->swaybg_client != NULL) {
+				wl_client_destroy(old_config->swaybg_client);
+			}
+			spawn_swaybg();
+		}
 
 		config->reloading = false;
 		if (is_active) {
-			request_modeset();
+			if (changes & CONFIG_DIFF_OUTPUTS) {
+				request_modeset();
+			}
+			if (changes & CONFIG_DIFF_EFFECTS) {
+				if (config->corner_radius != old_config->corner_radius) {
+					root_for_each_container(reset_corner_radius_iterator, NULL);
+				}
+				output_apply_effects();
+			}
+			if (changes & CONFIG_DIFF_LAYER_CRITERIA) {
+				layer_criteria_apply(NULL);
+			}
 			if (config->swaynag_config_errors.client != NULL) {
 				swaynag_show(&config->swaynag_config_errors);
 			}
@@ -708,6 +776,7 @@ bool load_main_config(const char *file, bool is_active, bool validating) {
 		free_config(old_config);
 	}
 	config->reading = false;
+	config_cache_save(config);
 	return success;
 }
 
@@ -0,0 +1,647 @@
+#include <dirent.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "hash.h"
+#include "list.h"
+#include "log.h"
+#include "sway/config.h"
+#include "sway/config_cache.h"
+#include "stringop.h"
+
+#define CONFIG_CACHE_MAGIC 0x43584653 // "SFXC"
+#define CONFIG_CACHE_VERSION 2
+#define CONFIG_CACHE_MAX_KEYMAPS 8
+#define CONFIG_CACHE_MAX_STRING (16 * 1024 * 1024)
+
+// The names a keymap was compiled from, then the XKB_DEFAULT_* variables
+// that fill in the empty ones unless the context ignores them
+#define KEYMAP_KEY_LENGTH 10
+
+static const char *const keymap_env[] = {
+	"XKB_DEFAULT_RULES",
+	"XKB_DEFAULT_MODEL",
+	"XKB_DEFAULT_LAYOUT",
+	"XKB_DEFAULT_VARIANT",
+	"XKB_DEFAULT_OPTIONS",
+};
+
+// The directories libxkbcommon includes keymap components from, below each
+// path of its default include path
+static const char *const xkb_component_dirs[] = {
+	"rules", "keycodes", "types", "compat", "symbols",
+};
+
+// A file or directory the cache was built from. The hash of a directory
+// covers the files below it. Paths that did not exist are kept with an mtime
+// of -1, so that creating them invalidates the cache.
+struct cache_dep {
+	char *path;
+	int64_t mtime_sec, mtime_nsec;
+	uint64_t size;
+	uint32_t hash;
+};
+
+struct cache_keymap {
+	char *key[KEYMAP_KEY_LENGTH];
+	char *text; // read from the cache file, or serialized when saving
+	struct xkb_keymap *keymap; // once compiled or parsed
+};
+
+static struct {
+	bool loaded;
+	bool enabled; // the last config, or the cache file, asked for it
+	bool dirty;
+	list_t *deps; // struct cache_dep *, as read from or written to disk
+	list_t *keymaps; // struct cache_keymap *
+} cache = {0};
+
+static char *cache_dir(void) {
+	const char *cache_home = getenv("XDG_CACHE_HOME");
+	if (cache_home && *cache_home) {
+		return format_str("%s/scroll", cache_home);
+	}
+	const char *home = getenv("HOME");
+	if (!home) {
+		return NULL;
+	}
+	return format_str("%s/.cache/scroll", home);
+}
+
+static char *cache_path(void) {
+	char *dir = cache_dir();
+	if (!dir) {
+		return NULL;
+	}
+	char *path = format_str("%s/config.cache", dir);
+	free(dir);
+	return path;
+}
+
+static bool file_hash(const char *path, uint32_t *hash) {
+	FILE *f = fopen(path, "rb");
+	if (!f) {
+		return false;
+	}
+	uint32_t h = FNV1A_INIT;
+	unsigned char buf[4096];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+		h = fnv1a(h, buf, n);
+	}
+	bool ok = !ferror(f);
+	fclose(f);
+	*hash = h;
+	return ok;
+}
+
+// Adds up the path, mtime and size of each file below the directory. Editing
+// a file in place doesn't change the mtime of its directory, and there are
+// too many XKB files to hash their contents on every start.
+static void dir_hash(const char *path, uint32_t *hash) {
+	DIR *dir = opendir(path);
+	if (!dir) {
+		return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir))) {
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+			continue;
+		}
+		char *entry_path = format_str("%s/%s", path, entry->d_name);
+		struct stat sb;
+		if (!entry_path || lstat(entry_path, &sb) != 0) {
+			free(entry_path);
+			continue;
+		}
+		if (S_ISDIR(sb.st_mode)) {
+			dir_hash(entry_path, hash);
+		} else {
+			// Follow links to files, keep dangling ones as they are
+			stat(entry_path, &sb);
+			int64_t stamp[] = {
+				sb.st_mtim.tv_sec, sb.st_mtim.tv_nsec, sb.st_size,
+			};
+			// readdir() order isn't stable, so the sum ignores it
+			*hash += fnv1a(fnv1a_str(entry_path), stamp, sizeof(stamp));
+		}
+		free(entry_path);
+	}
+	closedir(dir);
+}
+
+static void cache_dep_destroy(struct cache_dep *dep) {
+	if (dep) {
+		free(dep->path);
+		free(dep);
+	}
+}
+
+static struct cache_dep *cache_dep_create(const char *path) {
+	struct stat sb;
+	bool exists = stat(path, &sb) == 0;
+	if (!exists && errno != ENOENT && errno != ENOTDIR) {
+		return NULL;
+	}
+	struct cache_dep *dep = calloc(1, sizeof(*dep));
+	if (!dep || !(dep->path = strdup(path))) {
+		cache_dep_destroy(dep);
+		return NULL;
+	}
+	if (!exists) {
+		dep->mtime_sec = -1;
+		return dep;
+	}
+	if (S_ISDIR(sb.st_mode)) {
+		dir_hash(path, &dep->hash);
+	} else if (!file_hash(path, &dep->hash)) {
+		cache_dep_destroy(dep);
+		return NULL;
+	}
+	dep->mtime_sec = sb.st_mtim.tv_sec;
+	dep->mtime_nsec = sb.st_mtim.tv_nsec;
+	dep->size = sb.st_size;
+	return dep;
+}
+
+static bool cache_dep_equal(const struct cache_dep *a,
+		const struct cache_dep *b) {
+	return strcmp(a->path, b->path) == 0 &&
+		a->mtime_sec == b->mtime_sec && a->mtime_nsec == b->mtime_nsec &&
+		a->size == b->size && a->hash == b->hash;
+}
+
+static bool cache_dep_is_current(const struct cache_dep *dep) {
+	struct cache_dep *current = cache_dep_create(dep->path);
+	bool is_current = current && cache_dep_equal(current, dep);
+	cache_dep_destroy(current);
+	return is_current;
+}
+
+static void add_dep(list_t *deps, const char *path) {
+	struct cache_dep *dep = path ? cache_dep_create(path) : NULL;
+	if (!dep) {
+		return;
+	}
+	for (int i = 0; i < deps->length; ++i) {
+		if (cache_dep_equal(deps->items[i], dep)) {
+			cache_dep_destroy(dep);
+			return;
+		}
+	}
+	list_add(deps, dep);
+}
+
+static const char *xkb_config_root(void) {
+	const char *xkb_root = getenv("XKB_CONFIG_ROOT");
+	return xkb_root && *xkb_root ? xkb_root : "/usr/share/X11/xkb";
+}
+
+// The component directories of each path libxkbcommon searches by default,
+// in the order it searches them
+static void add_xkb_include_deps(list_t *deps) {
+	char *include_dirs[4] = {0};
+	const char *config_home = getenv("XDG_CONFIG_HOME");
+	const char *home = getenv("HOME");
+	if (config_home && *config_home) {
+		include_dirs[0] = format_str("%s/xkb", config_home);
+	} else if (home) {
+		include_dirs[0] = format_str("%s/.config/xkb", home);
+	}
+	if (home) {
+		include_dirs[1] = format_str("%s/.xkb", home);
+	}
+	const char *extra_path = getenv("XKB_CONFIG_EXTRA_PATH");
+	include_dirs[2] = strdup(extra_path && *extra_path ? extra_path : "/etc/xkb");
+	include_dirs[3] = strdup(xkb_config_root());
+
+	for (size_t i = 0; i < sizeof(include_dirs) / sizeof(include_dirs[0]); ++i) {
+		if (!include_dirs[i]) {
+			continue;
+		}
+		for (size_t j = 0; j < sizeof(xkb_component_dirs) /
+				sizeof(xkb_component_dirs[0]); ++j) {
+			char *path = format_str("%s/%s", include_dirs[i],
+				xkb_component_dirs[j]);
+			add_dep(deps, path);
+			free(path);
+		}
+		free(include_dirs[i]);
+	}
+}
+
+// Whether the include path deps of the cache file are those of this session
+static bool xkb_include_deps_match(list_t *cached) {
+	list_t *deps = create_list();
+	add_xkb_include_deps(deps);
+	bool match = true;
+	for (int i = 0; i < deps->length; ++i) {
+		bool found = false;
+		for (int j = 0; j < cached->length && !found; ++j) {
+			found = cache_dep_equal(cached->items[j], deps->items[i]);
+		}
+		match = match && found;
+		cache_dep_destroy(deps->items[i]);
+	}
+	list_free(deps);
+	return match;
+}
+
+static void cache_keymap_destroy(struct cache_keymap *entry) {
+	if (!entry) {
+		return;
+	}
+	for (int i = 0; i < KEYMAP_KEY_LENGTH; ++i) {
+		free(entry->key[i]);
+	}
+	free(entry->text);
+	xkb_keymap_unref(entry->keymap);
+	free(entry);
+}
+
+static void cache_clear(void) {
+	while (cache.deps->length) {
+		cache_dep_destroy(cache.deps->items[0]);
+		list_del(cache.deps, 0);
+	}
+	while (cache.keymaps->length) {
+		cache_keymap_destroy(cache.keymaps->items[0]);
+		list_del(cache.keymaps, 0);
+	}
+}
+
+static void keymap_key(const struct xkb_rule_names *names,
+		uint32_t context_flags, const char *key[static KEYMAP_KEY_LENGTH]) {
+	const char *fields[] = {
+		names->rules, names->model, names->layout, names->variant,
+		names->options,
+	};
+	bool use_env = !(context_flags & XKB_CONTEXT_NO_ENVIRONMENT_NAMES);
+	for (int i = 0; i < 5; ++i) {
+		key[i] = fields[i];
+		key[i + 5] = use_env ? getenv(keymap_env[i]) : NULL;
+	}
+}
+
+static bool key_str_equal(const char *a, const char *b) {
+	// libxkbcommon treats empty names like missing ones
+	if (!a || !*a || !b || !*b) {
+		return (!a || !*a) && (!b || !*b);
+	}
+	return strcmp(a, b) == 0;
+}
+
+static struct cache_keymap *find_keymap(const char *key[static KEYMAP_KEY_LENGTH]) {
+	for (int i = 0; i < cache.keymaps->length; ++i) {
+		struct cache_keymap *entry = cache.keymaps->items[i];
+		int j = 0;
+		while (j < KEYMAP_KEY_LENGTH && key_str_equal(entry->key[j], key[j])) {
+			++j;
+		}
+		if (j == KEYMAP_KEY_LENGTH) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static bool read_u32(FILE *f, uint32_t *value) {
+	return fread(value, sizeof(*value), 1, f) == 1;
+}
+
+static bool read_u64(FILE *f, uint64_t *value) {
+	return fread(value, sizeof(*value), 1, f) == 1;
+}
+
+// NULL strings are stored with a length of UINT32_MAX
+static bool read_str(FILE *f, char **str) {
+	uint32_t len;
+	*str = NULL;
+	if (!read_u32(f, &len)) {
+		return false;
+	}
+	if (len == UINT32_MAX) {
+		return true;
+	}
+	if (len > CONFIG_CACHE_MAX_STRING || !(*str = malloc(len + 1))) {
+		return false;
+	}
+	if (len > 0 && fread(*str, len, 1, f) != 1) {
+		free(*str);
+		*str = NULL;
+		return false;
+	}
+	(*str)[len] = '\0';
+	return true;
+}
+
+static void write_u32(FILE *f, uint32_t value) {
+	fwrite(&value, sizeof(value), 1, f);
+}
+
+static void write_u64(FILE *f, uint64_t value) {
+	fwrite(&value, sizeof(value), 1, f);
+}
+
+static void write_str(FILE *f, const char *str) {
+	if (!str) {
+		write_u32(f, UINT32_MAX);
+		return;
+	}
+	uint32_t len = strlen(str);
+	write_u32(f, len);
+	fwrite(str, len, 1, f);
+}
+
+static bool read_cache(FILE *f) {
+	uint32_t magic, version, count;
+	if (!read_u32(f, &magic) || magic != CONFIG_CACHE_MAGIC ||
+			!read_u32(f, &version) || version != CONFIG_CACHE_VERSION) {
+		return false;
+	}
+
+	// Keymaps are serialized by, and may use features of, one version
+	char *xkb_version;
+	if (!read_str(f, &xkb_version)) {
+		return false;
+	}
+	bool same_xkb = xkb_version && strcmp(xkb_version, XKBCOMMON_VERSION) == 0;
+	free(xkb_version);
+	if (!same_xkb) {
+		sway_log(SWAY_DEBUG, "Config cache: xkbcommon version changed");
+		return false;
+	}
+
+	if (!read_u32(f, &count)) {
+		return false;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		struct cache_dep *dep = calloc(1, sizeof(*dep));
+		uint64_t sec, nsec;
+		if (!dep) {
+			return false;
+		}
+		list_add(cache.deps, dep);
+		if (!read_str(f, &dep->path) || !dep->path ||
+				!read_u64(f, &sec) || !read_u64(f, &nsec) ||
+				!read_u64(f, &dep->size) || !read_u32(f, &dep->hash)) {
+			return false;
+		}
+		dep->mtime_sec = sec;
+		dep->mtime_nsec = nsec;
+		if (!cache_dep_is_current(dep)) {
+			sway_log(SWAY_DEBUG, "Config cache: %s changed", dep->path);
+			return false;
+		}
+	}
+
+	if (!read_u32(f, &count) || count > CONFIG_CACHE_MAX_KEYMAPS) {
+		return false;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		struct cache_keymap *entry = calloc(1, sizeof(*entry));
+		if (!entry) {
+			return false;
+		}
+		list_add(cache.keymaps, entry);
+		for (int j = 0; j < KEYMAP_KEY_LENGTH; ++j) {
+			if (!read_str(f, &entry->key[j])) {
+				return false;
+			}
+		}
+		if (!read_str(f, &entry->text) || !entry->text) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void config_cache_load(void) {
+	if (cache.loaded) {
+		return;
+	}
+	cache.loaded = true;
+	cache.deps = create_list();
+	cache.keymaps = create_list();
+
+	char *path = cache_path();
+	FILE *f = path ? fopen(path, "rb") : NULL;
+	if (!f) {
+		free(path);
+		return;
+	}
+	// The cache only exists while the config enables it
+	cache.enabled = true;
+	if (read_cache(f) && xkb_include_deps_match(cache.deps)) {
+		sway_log(SWAY_DEBUG, "Loaded %d keymaps from config cache %s",
+			cache.keymaps->length, path);
+	} else {
+		sway_log(SWAY_DEBUG, "Config cache %s is stale", path);
+		cache_clear();
+		cache.dirty = true;
+	}
+	fclose(f);
+	free(path);
+}
+
+struct xkb_keymap *config_cache_get_keymap(struct xkb_context *context,
+		const struct xkb_rule_names *names, uint32_t context_flags) {
+	if (!cache.enabled || !context) {
+		return NULL;
+	}
+	const char *key[KEYMAP_KEY_LENGTH];
+	keymap_key(names, context_flags, key);
+	struct cache_keymap *entry = find_keymap(key);
+	if (!entry) {
+		return NULL;
+	}
+	if (!entry->keymap) {
+		entry->keymap = xkb_keymap_new_from_string(context, entry->text,
+			XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+		if (!entry->keymap) {
+			sway_log(SWAY_DEBUG, "Unable to parse cached keymap");
+			list_del(cache.keymaps, list_find(cache.keymaps, entry));
+			cache_keymap_destroy(entry);
+			cache.dirty = true;
+			return NULL;
+		}
+	}
+	return xkb_keymap_ref(entry->keymap);
+}
+
+void config_cache_add_keymap(const struct xkb_rule_names *names,
+		uint32_t context_flags, struct xkb_keymap *keymap) {
+	const char *key[KEYMAP_KEY_LENGTH];
+	keymap_key(names, context_flags, key);
+	if (!cache.keymaps || find_keymap(key)) {
+		return;
+	}
+
+	struct cache_keymap *entry = calloc(1, sizeof(*entry));
+	if (!entry) {
+		return;
+	}
+	for (int i = 0; i < KEYMAP_KEY_LENGTH; ++i) {
+		if (key[i] && !(entry->key[i] = strdup(key[i]))) {
+			cache_keymap_destroy(entry);
+			return;
+		}
+	}
+	entry->keymap = xkb_keymap_ref(keymap);
+
+	if (cache.keymaps->length >= CONFIG_CACHE_MAX_KEYMAPS) {
+		cache_keymap_destroy(cache.keymaps->items[0]);
+		list_del(cache.keymaps, 0);
+	}
+	list_add(cache.keymaps, entry);
+	cache.dirty = true;
+}
+
+// The files of the config, the XKB include path and the rules each keymap
+// was compiled with
+static list_t *collect_deps(struct sway_config *config) {
+	list_t *deps = create_list();
+	for (int i = 0; i < config->config_chain->length; ++i) {
+		add_dep(deps, config->config_chain->items[i]);
+	}
+
+	add_xkb_include_deps(deps);
+	for (int i = 0; i < cache.keymaps->length; ++i) {
+		struct cache_keymap *entry = cache.keymaps->items[i];
+		const char *rules = entry->key[0] && *entry->key[0] ? entry->key[0] :
+			entry->key[5] && *entry->key[5] ? entry->key[5] : "evdev";
+		char *path = format_str("%s/rules/%s", xkb_config_root(), rules);
+		add_dep(deps, path);
+		free(path);
+	}
+	return deps;
+}
+
+static bool deps_equal(list_t *a, list_t *b) {
+	if (a->length != b->length) {
+		return false;
+	}
+	for (int i = 0; i < a->length; ++i) {
+		if (!cache_dep_equal(a->items[i], b->items[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool make_cache_dir(void) {
+	char *dir = cache_dir();
+	if (!dir) {
+		return false;
+	}
+	// Create each missing parent of the directory
+	for (char *sep = strchr(dir + 1, '/'); sep; sep = strchr(sep + 1, '/')) {
+		*sep = '\0';
+		if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+			break;
+		}
+		*sep = '/';
+	}
+	bool ok = mkdir(dir, 0700) == 0 || errno == EEXIST;
+	if (!ok) {
+		sway_log_errno(SWAY_ERROR, "Unable to create %s", dir);
+	}
+	free(dir);
+	return ok;
+}
+
+static bool write_cache(const char *path, list_t *deps) {
+	if (!make_cache_dir()) {
+		return false;
+	}
+	char *tmp_path = format_str("%s.tmp", path);
+	FILE *f = tmp_path ? fopen(tmp_path, "wb") : NULL;
+	if (!f) {
+		sway_log_errno(SWAY_ERROR, "Unable to write config cache %s", path);
+		free(tmp_path);
+		return false;
+	}
+
+	write_u32(f, CONFIG_CACHE_MAGIC);
+	write_u32(f, CONFIG_CACHE_VERSION);
+	write_str(f, XKBCOMMON_VERSION);
+	write_u32(f, deps->length);
+	for (int i = 0; i < deps->length; ++i) {
+		struct cache_dep *dep = deps->items[i];
+		write_str(f, dep->path);
+		write_u64(f, dep->mtime_sec);
+		write_u64(f, dep->mtime_nsec);
+		write_u64(f, dep->size);
+		write_u32(f, dep->hash);
+	}
+
+	uint32_t count = 0;
+	for (int i = 0; i < cache.keymaps->length; ++i) {
+		struct cache_keymap *entry = cache.keymaps->items[i];
+		if (!entry->text && entry->keymap) {
+			entry->text = xkb_keymap_get_as_string(entry->keymap,
+				XKB_KEYMAP_FORMAT_TEXT_V1);
+		}
+		count += entry->text != NULL;
+	}
+	write_u32(f, count);
+	for (int i = 0; i < cache.keymaps->length; ++i) {
+		struct cache_keymap *entry = cache.keymaps->items[i];
+		if (!entry->text) {
+			continue;
+		}
+		for (int j = 0; j < KEYMAP_KEY_LENGTH; ++j) {
+			write_str(f, entry->key[j]);
+		}
+		write_str(f, entry->text);
+	}
+
+	bool ok = !ferror(f);
+	ok = fclose(f) == 0 && ok;
+	if (ok && rename(tmp_path, path) != 0) {
+		ok = false;
+	}
+	if (!ok) {
+		sway_log_errno(SWAY_ERROR, "Unable to write config cache %s", path);
+		unlink(tmp_path);
+	}
+	free(tmp_path);
+	return ok;
+}
+
+void config_cache_save(struct sway_config *config) {
+	config_cache_load();
+	cache.enabled = config->config_cache;
+
+	char *path = cache_path();
+	if (!path) {
+		return;
+	}
+	if (!cache.enabled) {
+		cache_clear();
+		if (unlink(path) == 0) {
+			sway_log(SWAY_DEBUG, "Removed config cache %s", path);
+		}
+		free(path);
+		return;
+	}
+
+	list_t *deps = collect_deps(config);
+	if (cache.dirty || !deps_equal(deps, cache.deps)) {
+		if (write_cache(path, deps)) {
+			sway_log(SWAY_DEBUG, "Wrote config cache %s", path);
+			list_t *old_deps = cache.deps;
+			cache.deps = deps;
+			deps = old_deps;
+			cache.dirty = false;
+		}
+	}
+	for (int i = 0; i < deps->length; ++i) {
+		cache_dep_destroy(deps->items[i]);
+	}
+	list_free(deps);
+	free(path);
+}
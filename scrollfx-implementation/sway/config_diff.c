@@ -0,0 +1,323 @@
+#include <string.h>
+#include <wlr/util/box.h>
+#include "list.h"
+#include "log.h"
+#include "sway/config.h"
+#include "sway/layer_criteria.h"
+
+typedef bool (*item_equal_func_t)(const void *a, const void *b);
+
+static bool str_equal(const char *a, const char *b) {
+	return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+// Lists that were never created compare like empty ones
+static bool list_equal(list_t *a, list_t *b, item_equal_func_t item_equal) {
+	int a_length = a ? a->length : 0;
+	int b_length = b ? b->length : 0;
+	if (a_length != b_length) {
+		return false;
+	}
+	for (int i = 0; i < a_length; ++i) {
+		if (!item_equal(a->items[i], b->items[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool uint32_equal(const void *a, const void *b) {
+	return *(const uint32_t *)a == *(const uint32_t *)b;
+}
+
+static bool double_equal(const void *a, const void *b) {
+	return *(const double *)a == *(const double *)b;
+}
+
+static bool box_equal(const struct wlr_box *a, const struct wlr_box *b) {
+	return a == b || (a && b && wlr_box_equal(a, b));
+}
+
+static bool binding_equal(const void *_a, const void *_b) {
+	const struct sway_binding *a = _a, *b = _b;
+	// order only counts bindings as they are read, it grows on every reload
+	return a->type == b->type && a->flags == b->flags &&
+		a->modifiers == b->modifiers && a->group == b->group &&
+		str_equal(a->input, b->input) && str_equal(a->command, b->command) &&
+		list_equal(a->keys, b->keys, uint32_equal) &&
+		list_equal(a->syms, b->syms, uint32_equal);
+}
+
+static bool switch_binding_equal(const void *_a, const void *_b) {
+	const struct sway_switch_binding *a = _a, *b = _b;
+	return a->type == b->type && a->trigger == b->trigger &&
+		a->flags == b->flags && str_equal(a->command, b->command);
+}
+
+static bool gesture_binding_equal(const void *_a, const void *_b) {
+	const struct sway_gesture_binding *a = _a, *b = _b;
+	return a->flags == b->flags && str_equal(a->input, b->input) &&
+		a->gesture.type == b->gesture.type &&
+		a->gesture.fingers == b->gesture.fingers &&
+		a->gesture.directions == b->gesture.directions &&
+		str_equal(a->command, b->command);
+}
+
+static bool mode_equal(const void *_a, const void *_b) {
+	const struct sway_mode *a = _a, *b = _b;
+	return str_equal(a->name, b->name) && a->pango == b->pango &&
+		list_equal(a->keysym_bindings, b->keysym_bindings, binding_equal) &&
+		list_equal(a->keycode_bindings, b->keycode_bindings, binding_equal) &&
+		list_equal(a->mouse_bindings, b->mouse_bindings, binding_equal) &&
+		list_equal(a->switch_bindings, b->switch_bindings,
+			switch_binding_equal) &&
+		list_equal(a->gesture_bindings, b->gesture_bindings,
+			gesture_binding_equal);
+}
+
+static bool bindings_equal(struct sway_config *a, struct sway_config *b) {
+	return a->floating_mod == b->floating_mod &&
+		a->floating_mod_inverse == b->floating_mod_inverse &&
+		a->dragging_key == b->dragging_key &&
+		a->resizing_key == b->resizing_key &&
+		list_equal(a->modes, b->modes, mode_equal);
+}
+
+static bool input_tool_equal(const void *_a, const void *_b) {
+	const struct input_config_tool *a = _a, *b = _b;
+	return a->type == b->type && a->mode == b->mode;
+}
+
+static bool mapped_from_region_equal(
+		const struct input_config_mapped_from_region *a,
+		const struct input_config_mapped_from_region *b) {
+	return a == b || (a && b && a->x1 == b->x1 && a->y1 == b->y1 &&
+		a->x2 == b->x2 && a->y2 == b->y2 && a->mm == b->mm);
+}
+
+static bool input_config_equal(const void *_a, const void *_b) {
+	const struct input_config *a = _a, *b = _b;
+	return str_equal(a->identifier, b->identifier) &&
+		str_equal(a->input_type, b->input_type) &&
+		a->accel_profile == b->accel_profile &&
+		a->calibration_matrix.configured == b->calibration_matrix.configured &&
+		memcmp(a->calibration_matrix.matrix, b->calibration_matrix.matrix,
+			sizeof(a->calibration_matrix.matrix)) == 0 &&
+		a->click_method == b->click_method &&
+		a->clickfinger_button_map == b->clickfinger_button_map &&
+		a->drag == b->drag && a->drag_lock == b->drag_lock &&
+		a->dwt == b->dwt && a->dwtp == b->dwtp &&
+		a->left_handed == b->left_handed &&
+		a->middle_emulation == b->middle_emulation &&
+		a->natural_scroll == b->natural_scroll &&
+		a->pointer_accel == b->pointer_accel &&
+		a->rotation_angle == b->rotation_angle &&
+		a->scroll_factor == b->scroll_factor &&
+		a->repeat_delay == b->repeat_delay &&
+		a->repeat_rate == b->repeat_rate &&
+		a->scroll_button == b->scroll_button &&
+		a->scroll_button_lock == b->scroll_button_lock &&
+		a->scroll_method == b->scroll_method &&
+		a->send_events == b->send_events && a->tap == b->tap &&
+		a->tap_button_map == b->tap_button_map &&
+		str_equal(a->xkb_layout, b->xkb_layout) &&
+		str_equal(a->xkb_model, b->xkb_model) &&
+		str_equal(a->xkb_options, b->xkb_options) &&
+		str_equal(a->xkb_rules, b->xkb_rules) &&
+		str_equal(a->xkb_variant, b->xkb_variant) &&
+		str_equal(a->xkb_file, b->xkb_file) &&
+		a->xkb_file_is_set == b->xkb_file_is_set &&
+		a->xkb_numlock == b->xkb_numlock &&
+		a->xkb_capslock == b->xkb_capslock &&
+		mapped_from_region_equal(a->mapped_from_region, b->mapped_from_region) &&
+		a->mapped_to == b->mapped_to &&
+		str_equal(a->mapped_to_output, b->mapped_to_output) &&
+		box_equal(a->mapped_to_region, b->mapped_to_region) &&
+		list_equal(a->tools, b->tools, input_tool_equal) &&
+		a->capturable == b->capturable && box_equal(&a->region, &b->region);
+}
+
+static bool seat_attachment_equal(const void *_a, const void *_b) {
+	const struct seat_attachment_config *a = _a, *b = _b;
+	return str_equal(a->identifier, b->identifier);
+}
+
+static bool seat_config_equal(const void *_a, const void *_b) {
+	const struct seat_config *a = _a, *b = _b;
+	return str_equal(a->name, b->name) && a->fallback == b->fallback &&
+		list_equal(a->attachments, b->attachments, seat_attachment_equal) &&
+		a->hide_cursor_timeout == b->hide_cursor_timeout &&
+		a->hide_cursor_when_typing == b->hide_cursor_when_typing &&
+		a->allow_constrain == b->allow_constrain &&
+		a->shortcuts_inhibit == b->shortcuts_inhibit &&
+		a->keyboard_grouping == b->keyboard_grouping &&
+		a->idle_inhibit_sources == b->idle_inhibit_sources &&
+		a->idle_wake_sources == b->idle_wake_sources &&
+		str_equal(a->xcursor_theme.name, b->xcursor_theme.name) &&
+		a->xcursor_theme.size == b->xcursor_theme.size;
+}
+
+static bool output_config_equal(const void *_a, const void *_b) {
+	const struct output_config *a = _a, *b = _b;
+	// Color transforms are loaded again on every read, so a configured one
+	// always counts as changed
+	return str_equal(a->name, b->name) && a->enabled == b->enabled &&
+		a->power == b->power && a->width == b->width &&
+		a->height == b->height && a->refresh_rate == b->refresh_rate &&
+		a->custom_mode == b->custom_mode &&
+		memcmp(&a->drm_mode, &b->drm_mode, sizeof(a->drm_mode)) == 0 &&
+		a->x == b->x && a->y == b->y && a->scale == b->scale &&
+		a->scale_force == b->scale_force &&
+		a->scale_filter == b->scale_filter &&
+		a->transform == b->transform && a->subpixel == b->subpixel &&
+		a->max_render_time == b->max_render_time &&
+		a->adaptive_sync == b->adaptive_sync &&
+		a->render_bit_depth == b->render_bit_depth &&
+		a->set_color_transform == b->set_color_transform &&
+		a->color_transform == b->color_transform &&
+		a->allow_tearing == b->allow_tearing &&
+		a->layout_type == b->layout_type &&
+		a->layout_default_width == b->layout_default_width &&
+		a->layout_default_height == b->layout_default_height &&
+		list_equal(a->layout_widths, b->layout_widths, double_equal) &&
+		list_equal(a->layout_heights, b->layout_heights, double_equal) &&
+		str_equal(a->background, b->background) &&
+		str_equal(a->background_option, b->background_option) &&
+		str_equal(a->background_fallback, b->background_fallback);
+}
+
+static bool output_background_equal(const void *_a, const void *_b) {
+	const struct output_config *a = _a, *b = _b;
+	return str_equal(a->name, b->name) &&
+		str_equal(a->background, b->background) &&
+		str_equal(a->background_option, b->background_option) &&
+		str_equal(a->background_fallback, b->background_fallback);
+}
+
+// Everything that is drawn into title and border textures
+static bool colors_equal(struct sway_config *a, struct sway_config *b) {
+	return memcmp(&a->border_colors, &b->border_colors,
+			sizeof(a->border_colors)) == 0 &&
+		a->has_focused_tab_title == b->has_focused_tab_title &&
+		str_equal(a->font, b->font) && a->pango_markup == b->pango_markup &&
+		a->title_align == b->title_align && a->show_marks == b->show_marks;
+}
+
+static bool effects_equal(struct sway_config *a, struct sway_config *b) {
+	return a->corner_radius == b->corner_radius &&
+		a->smart_corner_radius == b->smart_corner_radius &&
+		a->default_dim_inactive == b->default_dim_inactive &&
+		memcmp(&a->dim_inactive_colors, &b->dim_inactive_colors,
+			sizeof(a->dim_inactive_colors)) == 0 &&
+		a->blur_enabled == b->blur_enabled && a->blur_xray == b->blur_xray &&
+		memcmp(&a->blur_data, &b->blur_data, sizeof(a->blur_data)) == 0 &&
+		a->shadow_enabled == b->shadow_enabled &&
+		a->shadows_on_csd_enabled == b->shadows_on_csd_enabled &&
+		a->shadow_blur_sigma == b->shadow_blur_sigma &&
+		memcmp(a->shadow_color, b->shadow_color, sizeof(a->shadow_color)) == 0 &&
+		memcmp(a->shadow_inactive_color, b->shadow_inactive_color,
+			sizeof(a->shadow_inactive_color)) == 0 &&
+		a->shadow_offset_x == b->shadow_offset_x &&
+		a->shadow_offset_y == b->shadow_offset_y &&
+		a->titlebar_separator == b->titlebar_separator &&
+		a->scratchpad_minimize == b->scratchpad_minimize &&
+		a->effects_lod.enabled == b->effects_lod.enabled &&
+		a->effects_lod.threshold == b->effects_lod.threshold &&
+		a->effects_lod.hysteresis == b->effects_lod.hysteresis &&
+		a->effects_lod.blur_passes == b->effects_lod.blur_passes &&
+		a->effects_min_scale == b->effects_min_scale;
+}
+
+static bool layer_criteria_equal(const void *_a, const void *_b) {
+	const struct layer_criteria *a = _a, *b = _b;
+	// The effects are parsed from cmdlist
+	return str_equal(a->namespace, b->namespace) &&
+		str_equal(a->cmdlist, b->cmdlist);
+}
+
+static bool animations_equal(struct sway_animations_config *a,
+		struct sway_animations_config *b) {
+	// Paths are built again on every read and opaque here, so only which of
+	// them are set is compared
+	return a->enabled == b->enabled && a->frequency_ms == b->frequency_ms &&
+		a->style == b->style &&
+		!a->anim_default == !b->anim_default &&
+		!a->window_open == !b->window_open &&
+		!a->window_size == !b->window_size &&
+		!a->window_move == !b->window_move &&
+		!a->workspace_switch == !b->workspace_switch;
+}
+
+static const char *config_diff_part_name(enum config_diff_part part) {
+	switch (part) {
+	case CONFIG_DIFF_BINDINGS:
+		return "bindings";
+	case CONFIG_DIFF_OUTPUTS:
+		return "outputs";
+	case CONFIG_DIFF_INPUTS:
+		return "inputs";
+	case CONFIG_DIFF_SEATS:
+		return "seats";
+	case CONFIG_DIFF_COLORS:
+		return "colors";
+	case CONFIG_DIFF_EFFECTS:
+		return "effects";
+	case CONFIG_DIFF_LAYER_CRITERIA:
+		return "layer_criteria";
+	case CONFIG_DIFF_ANIMATIONS:
+		return "animations";
+	case CONFIG_DIFF_SWAYBG:
+		return "swaybg";
+	case CONFIG_DIFF_ALL:
+		break;
+	}
+	return "unknown";
+}
+
+uint32_t config_diff(struct sway_config *old_config,
+		struct sway_config *new_config) {
+	uint32_t changes = 0;
+	if (!bindings_equal(old_config, new_config)) {
+		changes |= CONFIG_DIFF_BINDINGS;
+	}
+	if (!list_equal(old_config->output_configs, new_config->output_configs,
+			output_config_equal)) {
+		changes |= CONFIG_DIFF_OUTPUTS;
+	}
+	if (!list_equal(old_config->input_configs, new_config->input_configs,
+			input_config_equal) ||
+			!list_equal(old_config->input_type_configs,
+				new_config->input_type_configs, input_config_equal)) {
+		changes |= CONFIG_DIFF_INPUTS;
+	}
+	if (!list_equal(old_config->seat_configs, new_config->seat_configs,
+			seat_config_equal)) {
+		changes |= CONFIG_DIFF_SEATS;
+	}
+	if (!colors_equal(old_config, new_config)) {
+		changes |= CONFIG_DIFF_COLORS;
+	}
+	if (!effects_equal(old_config, new_config)) {
+		changes |= CONFIG_DIFF_EFFECTS;
+	}
+	if (!list_equal(old_config->layer_criteria, new_config->layer_criteria,
+			layer_criteria_equal)) {
+		changes |= CONFIG_DIFF_LAYER_CRITERIA;
+	}
+	if (!animations_equal(&old_config->animations, &new_config->animations)) {
+		changes |= CONFIG_DIFF_ANIMATIONS;
+	}
+	if (!str_equal(old_config->swaybg_command, new_config->swaybg_command) ||
+			!list_equal(old_config->output_configs,
+				new_config->output_configs, output_background_equal)) {
+		changes |= CONFIG_DIFF_SWAYBG;
+	}
+
+	for (uint32_t part = 1; part & CONFIG_DIFF_ALL; part <<= 1) {
+		if (changes & part) {
+			sway_log(SWAY_DEBUG, "Config reload changed %s",
+				config_diff_part_name(part));
+		}
+	}
+	return changes;
+}
@@ -0,0 +1,291 @@
+#define PCRE2_CODE_UNIT_WIDTH 8
+#include <pcre2.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wlr/config.h>
+#include "hash.h"
+#include "list.h"
+#include "log.h"
+#include "sway/criteria.h"
+#include "sway/criteria_index.h"
+#include "sway/tree/container.h"
+#include "sway/tree/root.h"
+#include "sway/tree/view.h"
+#include "sway/tree/workspace.h"
+
+#define CRITERIA_INDEX_CHAINS 128
+
+struct index_entry {
+	char *value;
+	uint32_t hash;
+	list_t *containers; // struct sway_container *
+	struct index_entry *next; // in its hash chain
+};
+
+struct index_table {
+	struct index_entry *chains[CRITERIA_INDEX_CHAINS];
+	list_t *entries; // struct index_entry *, for pattern scans
+};
+
+static struct index_table tables[CRITERIA_INDEX_FIELD_COUNT];
+
+static struct index_entry *table_find(struct index_table *table,
+		const char *value, uint32_t hash) {
+	struct index_entry *entry = table->chains[hash % CRITERIA_INDEX_CHAINS];
+	for (; entry; entry = entry->next) {
+		if (entry->hash == hash && strcmp(entry->value, value) == 0) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+static void table_add(struct index_table *table, const char *value,
+		struct sway_container *con) {
+	uint32_t hash = fnv1a_str(value);
+	struct index_entry *entry = table_find(table, value, hash);
+	if (!entry) {
+		if (!table->entries && !(table->entries = create_list())) {
+			return;
+		}
+		entry = calloc(1, sizeof(*entry));
+		if (!entry || !(entry->value = strdup(value)) ||
+				!(entry->containers = create_list())) {
+			sway_log(SWAY_ERROR, "Unable to allocate criteria index entry");
+			if (entry) {
+				free(entry->value);
+			}
+			free(entry);
+			return;
+		}
+		entry->hash = hash;
+		entry->next = table->chains[hash % CRITERIA_INDEX_CHAINS];
+		table->chains[hash % CRITERIA_INDEX_CHAINS] = entry;
+		list_add(table->entries, entry);
+	}
+	list_add(entry->containers, con);
+}
+
+static void table_remove(struct index_table *table, const char *value,
+		struct sway_container *con) {
+	uint32_t hash = fnv1a_str(value);
+	struct index_entry *entry = table_find(table, value, hash);
+	if (!entry) {
+		return;
+	}
+	int index = list_find(entry->containers, con);
+	if (index != -1) {
+		list_del(entry->containers, index);
+	}
+	if (entry->containers->length > 0) {
+		return;
+	}
+
+	struct index_entry **link = &table->chains[hash % CRITERIA_INDEX_CHAINS];
+	for (; *link != entry; link = &(*link)->next) {}
+	*link = entry->next;
+	list_del(table->entries, list_find(table->entries, entry));
+	list_free(entry->containers);
+	free(entry->value);
+	free(entry);
+}
+
+static const char *view_get_index_value(struct sway_view *view,
+		enum criteria_index_field field) {
+	switch (field) {
+	case CRITERIA_INDEX_APP_ID:
+		return view_get_app_id(view);
+	case CRITERIA_INDEX_CLASS:
+		return view_get_class(view);
+	case CRITERIA_INDEX_INSTANCE:
+		return view_get_instance(view);
+	case CRITERIA_INDEX_SHELL:
+		return view_get_shell(view);
+	case CRITERIA_INDEX_MARK:
+	case CRITERIA_INDEX_FIELD_COUNT:
+		break;
+	}
+	return NULL;
+}
+
+void criteria_index_add_view(struct sway_view *view) {
+	struct sway_container *con = view->container;
+	for (int i = 0; i < CRITERIA_INDEX_VIEW_FIELDS; ++i) {
+		const char *value = view_get_index_value(view, i);
+		if (value && (con->index_keys[i] = strdup(value))) {
+			table_add(&tables[i], value, con);
+		}
+	}
+}
+
+void criteria_index_remove_view(struct sway_view *view) {
+	struct sway_container *con = view->container;
+	for (int i = 0; i < CRITERIA_INDEX_VIEW_FIELDS; ++i) {
+		if (con->index_keys[i]) {
+			table_remove(&tables[i], con->index_keys[i], con);
+			free(con->index_keys[i]);
+			con->index_keys[i] = NULL;
+		}
+	}
+}
+
+void criteria_index_update_view(struct sway_view *view) {
+	// Unmapped views are not indexed
+	if (!view->container || !view->surface) {
+		return;
+	}
+	criteria_index_remove_view(view);
+	criteria_index_add_view(view);
+}
+
+void criteria_index_add_mark(struct sway_container *con, const char *mark) {
+	table_add(&tables[CRITERIA_INDEX_MARK], mark, con);
+}
+
+void criteria_index_remove_mark(struct sway_container *con, const char *mark) {
+	table_remove(&tables[CRITERIA_INDEX_MARK], mark, con);
+}
+
+struct sway_container *criteria_index_find_mark(const char *mark) {
+	struct index_entry *entry = table_find(&tables[CRITERIA_INDEX_MARK],
+		mark, fnv1a_str(mark));
+	for (int i = 0; entry && i < entry->containers->length; ++i) {
+		struct sway_container *con = entry->containers->items[i];
+		// Destroyed containers keep their marks until they are freed
+		if (!con->node.destroying) {
+			return con;
+		}
+	}
+	return NULL;
+}
+
+static bool pattern_matches(struct pattern *pattern, const char *value) {
+	pcre2_match_data *match_data =
+		pcre2_match_data_create_from_pattern(pattern->regex, NULL);
+	if (!match_data) {
+		return true; // let the full criteria check decide
+	}
+	int ret = pcre2_match(pattern->regex, (PCRE2_SPTR)value,
+		strlen(value), 0, 0, match_data, NULL);
+	pcre2_match_data_free(match_data);
+	return ret >= 0;
+}
+
+static void add_candidate(list_t *candidates, struct sway_container *con) {
+	if (!con->node.destroying) {
+		list_add(candidates, con);
+	}
+}
+
+// Containers filed under a value that matches the pattern, or NULL if the
+// pattern cannot use the index
+static list_t *table_get_candidates(struct index_table *table,
+		struct pattern *pattern) {
+	if (!pattern || pattern->match_type != PATTERN_PCRE2) {
+		return NULL;
+	}
+	list_t *candidates = create_list();
+	for (int i = 0; table->entries && i < table->entries->length; ++i) {
+		struct index_entry *entry = table->entries->items[i];
+		if (!pattern_matches(pattern, entry->value)) {
+			continue;
+		}
+		for (int j = 0; j < entry->containers->length; ++j) {
+			struct sway_container *con = entry->containers->items[j];
+			// A container can have several marks matching the pattern
+			if (table != &tables[CRITERIA_INDEX_MARK] ||
+					list_find(candidates, con) == -1) {
+				add_candidate(candidates, con);
+			}
+		}
+	}
+	return candidates;
+}
+
+struct workspace_candidates_data {
+	struct pattern *pattern;
+	list_t *candidates;
+};
+
+static void add_workspace_candidate(struct sway_container *con, void *data) {
+	add_candidate(data, con);
+}
+
+static void workspace_candidates_iterator(struct sway_workspace *ws,
+		void *data) {
+	struct workspace_candidates_data *wc = data;
+	if (ws->name && pattern_matches(wc->pattern, ws->name)) {
+		workspace_for_each_container(ws, add_workspace_candidate,
+			wc->candidates);
+	}
+}
+
+// Workspaces are few, so the tree itself serves as their index
+static list_t *workspace_get_candidates(struct pattern *pattern) {
+	if (!pattern || pattern->match_type != PATTERN_PCRE2) {
+		return NULL;
+	}
+	struct workspace_candidates_data data = {
+		.pattern = pattern,
+		.candidates = create_list(),
+	};
+	root_for_each_workspace(workspace_candidates_iterator, &data);
+	// Saved workspaces
+	for (int i = 0; i < root->fallback_output->workspaces->length; ++i) {
+		workspace_candidates_iterator(
+			root->fallback_output->workspaces->items[i], &data);
+	}
+	return data.candidates;
+}
+
+static list_t *con_id_get_candidates(uint32_t con_id) {
+	if (!con_id) {
+		return NULL;
+	}
+	list_t *candidates = create_list();
+	struct sway_container *con = root_find_container_by_id(con_id);
+	if (con) {
+		add_candidate(candidates, con);
+	}
+	return candidates;
+}
+
+// Keeps the smaller of two candidate lists
+static list_t *pick_candidates(list_t *best, list_t *candidates) {
+	if (!candidates) {
+		return best;
+	}
+	if (!best || candidates->length < best->length) {
+		list_free(best);
+		return candidates;
+	}
+	list_free(candidates);
+	return best;
+}
+
+list_t *criteria_index_get_candidates(struct criteria *criteria) {
+	list_t *best = con_id_get_candidates(criteria->con_id);
+	if (best) {
+		return best;
+	}
+	// A container without a view matches on con_mark alone, so the view
+	// properties can't narrow the marked containers down
+	best = table_get_candidates(&tables[CRITERIA_INDEX_MARK],
+		criteria->con_mark);
+	if (best) {
+		return best;
+	}
+	best = pick_candidates(best, table_get_candidates(
+		&tables[CRITERIA_INDEX_APP_ID], criteria->app_id));
+#if WLR_HAS_XWAYLAND
+	best = pick_candidates(best, table_get_candidates(
+		&tables[CRITERIA_INDEX_CLASS], criteria->class));
+	best = pick_candidates(best, table_get_candidates(
+		&tables[CRITERIA_INDEX_INSTANCE], criteria->instance));
+#endif
+	best = pick_candidates(best, table_get_candidates(
+		&tables[CRITERIA_INDEX_SHELL], criteria->shell));
+	best = pick_candidates(best, workspace_get_candidates(criteria->workspace));
+	return best;
+}
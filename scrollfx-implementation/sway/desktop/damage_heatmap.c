@@ -0,0 +1,389 @@
+#include <json.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/util/box.h>
+#include <scenefx/types/wlr_scene.h>
+#include "list.h"
+#include "log.h"
+#include "sway/desktop/damage_heatmap.h"
+#include "sway/perf.h"
+#include "sway/tree/scene.h"
+
+#define DAMAGE_HEATMAP_TOP_CELLS 10
+
+struct damage_heatmap_output {
+	char *name;
+	int width, height; // buffer size the grid was last fed with
+	uint64_t frames;
+	uint64_t damaged_frames;
+	int64_t damaged_area;
+	uint32_t *cells; // frames in which each cell was damaged
+	uint64_t *cell_frame; // last frame counted for each cell
+};
+
+struct damage_heatmap_source {
+	char *name;
+	uint64_t events;
+	int64_t damaged_area; // layout pixels
+};
+
+static struct {
+	bool recording;
+	int columns, rows;
+	struct timespec start, end;
+	list_t *outputs; // struct damage_heatmap_output *
+	list_t *sources; // struct damage_heatmap_source *
+} heatmap = {0};
+
+static void heatmap_clear(void) {
+	if (heatmap.outputs) {
+		for (int i = 0; i < heatmap.outputs->length; ++i) {
+			struct damage_heatmap_output *output = heatmap.outputs->items[i];
+			free(output->name);
+			free(output->cells);
+			free(output->cell_frame);
+			free(output);
+		}
+		list_free(heatmap.outputs);
+		heatmap.outputs = NULL;
+	}
+	if (heatmap.sources) {
+		for (int i = 0; i < heatmap.sources->length; ++i) {
+			struct damage_heatmap_source *source = heatmap.sources->items[i];
+			free(source->name);
+			free(source);
+		}
+		list_free(heatmap.sources);
+		heatmap.sources = NULL;
+	}
+}
+
+void damage_heatmap_start(int columns, int rows) {
+	heatmap_clear();
+	heatmap.columns = columns;
+	heatmap.rows = rows;
+	heatmap.outputs = create_list();
+	heatmap.sources = create_list();
+	clock_gettime(CLOCK_MONOTONIC, &heatmap.start);
+	heatmap.recording = true;
+}
+
+void damage_heatmap_stop(void) {
+	if (heatmap.recording) {
+		clock_gettime(CLOCK_MONOTONIC, &heatmap.end);
+		heatmap.recording = false;
+	}
+}
+
+bool damage_heatmap_recording(void) {
+	return heatmap.recording;
+}
+
+static struct damage_heatmap_output *heatmap_get_output(const char *name) {
+	for (int i = 0; i < heatmap.outputs->length; ++i) {
+		struct damage_heatmap_output *output = heatmap.outputs->items[i];
+		if (strcmp(output->name, name) == 0) {
+			return output;
+		}
+	}
+
+	struct damage_heatmap_output *output = calloc(1, sizeof(*output));
+	size_t num_cells = (size_t)heatmap.columns * heatmap.rows;
+	if (output) {
+		output->cells = calloc(num_cells, sizeof(*output->cells));
+		output->cell_frame = calloc(num_cells, sizeof(*output->cell_frame));
+		output->name = strdup(name);
+	}
+	if (!output || !output->cells || !output->cell_frame || !output->name) {
+		sway_log(SWAY_ERROR, "Failed to allocate damage heatmap");
+		if (output) {
+			free(output->cells);
+			free(output->cell_frame);
+			free(output->name);
+			free(output);
+		}
+		return NULL;
+	}
+	list_add(heatmap.outputs, output);
+	return output;
+}
+
+void damage_heatmap_record_frame(struct wlr_output *wlr_output,
+		const pixman_region32_t *damage) {
+	if (!heatmap.recording || wlr_output->width <= 0 || wlr_output->height <= 0) {
+		return;
+	}
+
+	struct damage_heatmap_output *output = heatmap_get_output(wlr_output->name);
+	if (!output) {
+		return;
+	}
+	output->width = wlr_output->width;
+	output->height = wlr_output->height;
+	output->frames++;
+
+	int nrects;
+	const pixman_box32_t *rects =
+		pixman_region32_rectangles((pixman_region32_t *)damage, &nrects);
+	if (nrects > 0) {
+		output->damaged_frames++;
+	}
+
+	for (int i = 0; i < nrects; ++i) {
+		const pixman_box32_t *rect = &rects[i];
+		output->damaged_area +=
+			(int64_t)(rect->x2 - rect->x1) * (rect->y2 - rect->y1);
+
+		int x1 = (int64_t)rect->x1 * heatmap.columns / output->width;
+		int x2 = ((int64_t)rect->x2 * heatmap.columns - 1) / output->width;
+		int y1 = (int64_t)rect->y1 * heatmap.rows / output->height;
+		int y2 = ((int64_t)rect->y2 * heatmap.rows - 1) / output->height;
+		x1 = x1 < 0 ? 0 : x1;
+		y1 = y1 < 0 ? 0 : y1;
+		x2 = x2 >= heatmap.columns ? heatmap.columns - 1 : x2;
+		y2 = y2 >= heatmap.rows ? heatmap.rows - 1 : y2;
+
+		// Count each cell once per frame, even if several rects touch it
+		for (int y = y1; y <= y2; ++y) {
+			for (int x = x1; x <= x2; ++x) {
+				size_t cell = (size_t)y * heatmap.columns + x;
+				if (output->cell_frame[cell] != output->frames) {
+					output->cell_frame[cell] = output->frames;
+					output->cells[cell]++;
+				}
+			}
+		}
+	}
+}
+
+static void record_source(const char *name, const pixman_region32_t *damage,
+		double area_scale) {
+	int64_t area = 0;
+	int nrects;
+	const pixman_box32_t *rects =
+		pixman_region32_rectangles((pixman_region32_t *)damage, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		area += (int64_t)(rects[i].x2 - rects[i].x1) * (rects[i].y2 - rects[i].y1);
+	}
+	if (area == 0) {
+		return;
+	}
+
+	struct damage_heatmap_source *source = NULL;
+	for (int i = 0; i < heatmap.sources->length; ++i) {
+		struct damage_heatmap_source *it = heatmap.sources->items[i];
+		if (strcmp(it->name, name) == 0) {
+			source = it;
+			break;
+		}
+	}
+	if (!source) {
+		source = calloc(1, sizeof(*source));
+		if (!source || !(source->name = strdup(name))) {
+			sway_log(SWAY_ERROR, "Failed to allocate damage heatmap source");
+			free(source);
+			return;
+		}
+		list_add(heatmap.sources, source);
+	}
+
+	source->events++;
+	source->damaged_area += area * area_scale;
+}
+
+void damage_heatmap_record_source(struct sway_scene_node *node,
+		const pixman_region32_t *damage, double area_scale) {
+	if (!heatmap.recording) {
+		return;
+	}
+
+	char name[128];
+	perf_node_get_source_name(node, name, sizeof(name));
+	record_source(name, damage, area_scale);
+}
+
+void damage_heatmap_record_effect(struct sway_scene_node *node,
+		const char *effect, const pixman_region32_t *damage, double area_scale) {
+	if (!heatmap.recording) {
+		return;
+	}
+
+	char source_name[128];
+	perf_node_get_source_name(node, source_name, sizeof(source_name));
+	char name[160];
+	snprintf(name, sizeof(name), "%s:%s", effect, source_name);
+	record_source(name, damage, area_scale);
+}
+
+void damage_heatmap_record_shadow(struct sway_scene_node *node,
+		struct wlr_scene_shadow *shadow, const struct wlr_box *box,
+		const float color[static 4], float blur_sigma) {
+	if (!heatmap.recording) {
+		return;
+	}
+
+	bool moved = !shadow->node.enabled ||
+		shadow->node.x != box->x || shadow->node.y != box->y ||
+		shadow->width != box->width || shadow->height != box->height;
+	bool restyled = shadow->blur_sigma != blur_sigma ||
+		memcmp(shadow->color, color, sizeof(shadow->color)) != 0;
+	if (!moved && !restyled) {
+		return;
+	}
+
+	// The new box is drawn, and the old one uncovered if the shadow moved
+	pixman_region32_t damage;
+	pixman_region32_init_rect(&damage, box->x, box->y, box->width, box->height);
+	if (moved && shadow->node.enabled) {
+		pixman_region32_union_rect(&damage, &damage, shadow->node.x,
+			shadow->node.y, shadow->width, shadow->height);
+	}
+	damage_heatmap_record_effect(node, "shadow", &damage, 1.0);
+	pixman_region32_fini(&damage);
+}
+
+static bool export_pgm(struct damage_heatmap_output *output, const char *path) {
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		sway_log_errno(SWAY_ERROR, "Unable to write damage heatmap %s", path);
+		return false;
+	}
+
+	size_t num_cells = (size_t)heatmap.columns * heatmap.rows;
+	uint32_t max = 1;
+	for (size_t i = 0; i < num_cells; ++i) {
+		max = output->cells[i] > max ? output->cells[i] : max;
+	}
+
+	fprintf(file, "P5\n%d %d\n255\n", heatmap.columns, heatmap.rows);
+	for (size_t i = 0; i < num_cells; ++i) {
+		fputc((int)((uint64_t)output->cells[i] * 255 / max), file);
+	}
+	fclose(file);
+	return true;
+}
+
+struct heatmap_cell {
+	size_t index;
+	uint32_t frames;
+};
+
+static int cmp_cells_desc(const void *a, const void *b) {
+	const struct heatmap_cell *ca = a, *cb = b;
+	return ca->frames < cb->frames ? 1 : ca->frames > cb->frames ? -1 : 0;
+}
+
+static json_object *output_get_json(struct damage_heatmap_output *output,
+		const char *pgm_path) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "name", json_object_new_string(output->name));
+	json_object_object_add(object, "heatmap", json_object_new_string(pgm_path));
+	json_object_object_add(object, "frames", json_object_new_int64(output->frames));
+	json_object_object_add(object, "damaged_frames",
+		json_object_new_int64(output->damaged_frames));
+	json_object_object_add(object, "damaged_area",
+		json_object_new_int64(output->damaged_area));
+	int64_t full_area = (int64_t)output->width * output->height;
+	json_object_object_add(object, "mean_damage_percent",
+		json_object_new_double(output->frames > 0 && full_area > 0 ?
+			100.0 * output->damaged_area / (full_area * output->frames) : 0.0));
+
+	size_t num_cells = (size_t)heatmap.columns * heatmap.rows;
+	struct heatmap_cell *order = malloc(num_cells * sizeof(*order));
+	json_object *hottest = json_object_new_array();
+	if (order) {
+		for (size_t i = 0; i < num_cells; ++i) {
+			order[i] = (struct heatmap_cell){ .index = i, .frames = output->cells[i] };
+		}
+		qsort(order, num_cells, sizeof(*order), cmp_cells_desc);
+
+		for (size_t i = 0; i < num_cells && i < DAMAGE_HEATMAP_TOP_CELLS; ++i) {
+			if (order[i].frames == 0) {
+				break;
+			}
+			int column = order[i].index % heatmap.columns;
+			int row = order[i].index / heatmap.columns;
+			json_object *entry = json_object_new_object();
+			json_object_object_add(entry, "x",
+				json_object_new_int(column * output->width / heatmap.columns));
+			json_object_object_add(entry, "y",
+				json_object_new_int(row * output->height / heatmap.rows));
+			json_object_object_add(entry, "width",
+				json_object_new_int(output->width / heatmap.columns));
+			json_object_object_add(entry, "height",
+				json_object_new_int(output->height / heatmap.rows));
+			json_object_object_add(entry, "frames",
+				json_object_new_int64(order[i].frames));
+			json_object_array_add(hottest, entry);
+		}
+		free(order);
+	}
+	json_object_object_add(object, "hottest_cells", hottest);
+	return object;
+}
+
+static int cmp_sources_desc(const void *a, const void *b) {
+	const struct damage_heatmap_source *sa = *(void **)a, *sb = *(void **)b;
+	return sa->damaged_area < sb->damaged_area ? 1 :
+		sa->damaged_area > sb->damaged_area ? -1 : 0;
+}
+
+bool damage_heatmap_export(const char *prefix) {
+	if (!heatmap.outputs) {
+		return false;
+	}
+
+	struct timespec end = heatmap.end;
+	if (heatmap.recording) {
+		clock_gettime(CLOCK_MONOTONIC, &end);
+	}
+
+	bool ok = true;
+	json_object *summary = json_object_new_object();
+	json_object_object_add(summary, "duration_ms", json_object_new_int64(
+		(end.tv_sec - heatmap.start.tv_sec) * 1000 +
+		(end.tv_nsec - heatmap.start.tv_nsec) / 1000000));
+	json_object_object_add(summary, "columns", json_object_new_int(heatmap.columns));
+	json_object_object_add(summary, "rows", json_object_new_int(heatmap.rows));
+
+	json_object *outputs = json_object_new_array();
+	for (int i = 0; i < heatmap.outputs->length; ++i) {
+		struct damage_heatmap_output *output = heatmap.outputs->items[i];
+		char path[4096];
+		snprintf(path, sizeof(path), "%s-%s.pgm", prefix, output->name);
+		ok = export_pgm(output, path) && ok;
+		json_object_array_add(outputs, output_get_json(output, path));
+	}
+	json_object_object_add(summary, "outputs", outputs);
+
+	list_qsort(heatmap.sources, cmp_sources_desc);
+	json_object *sources = json_object_new_array();
+	for (int i = 0; i < heatmap.sources->length; ++i) {
+		struct damage_heatmap_source *source = heatmap.sources->items[i];
+		json_object *entry = json_object_new_object();
+		json_object_object_add(entry, "source", json_object_new_string(source->name));
+		json_object_object_add(entry, "events", json_object_new_int64(source->events));
+		json_object_object_add(entry, "damaged_area",
+			json_object_new_int64(source->damaged_area));
+		json_object_array_add(sources, entry);
+	}
+	json_object_object_add(summary, "sources", sources);
+
+	char path[4096];
+	snprintf(path, sizeof(path), "%s.json", prefix);
+	FILE *file = fopen(path, "w");
+	if (file) {
+		fputs(json_object_to_json_string_ext(summary, JSON_C_TO_STRING_PRETTY), file);
+		fputc('\n', file);
+		fclose(file);
+	} else {
+		sway_log_errno(SWAY_ERROR, "Unable to write damage summary %s", path);
+		ok = false;
+	}
+	json_object_put(summary);
+	return ok;
+}
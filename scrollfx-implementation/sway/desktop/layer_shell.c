@@ -12,6 +12,7 @@
 #include "log.h"
 #include "sway/config.h"
 #include "sway/scene_descriptor.h"
+#include "sway/desktop/damage_heatmap.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
@@ -94,9 +95,6 @@ static void arrange_surface(struct sway_output *output, const struct wlr_box *fu
 
 		// Configure shadow if enabled
 		if (surface->shadow_node) {
-			wlr_scene_node_set_enabled(&surface->shadow_node->node,
-				surface->shadow_enabled);
-
 			if (surface->shadow_enabled && surface->layer_surface->surface->mapped) {
 				struct wlr_layer_surface_v1 *layer_surface = surface->layer_surface;
 				int width = layer_surface->surface->current.width;
@@ -106,6 +104,16 @@ static void arrange_surface(struct sway_output *output, const struct wlr_box *fu
 				int shadow_width = width + config->shadow_blur_sigma * 2;
 				int shadow_height = height + config->shadow_blur_sigma * 2;
 
+				struct wlr_box shadow_box = {
+					.x = surface->shadow_node->node.x,
+					.y = surface->shadow_node->node.y,
+					.width = shadow_width,
+					.height = shadow_height,
+				};
+				damage_heatmap_record_shadow(&surface->tree->node,
+					surface->shadow_node, &shadow_box,
+					surface->shadow_node->color, config->shadow_blur_sigma);
+
 				wlr_scene_shadow_set_size(surface->shadow_node,
 					shadow_width, shadow_height);
 
@@ -132,6 +140,9 @@ static void arrange_surface(struct sway_output *output, const struct wlr_box *fu
 				wlr_scene_shadow_set_corner_radius(surface->shadow_node,
 					surface->corner_radius);
 			}
+
+			wlr_scene_node_set_enabled(&surface->shadow_node->node,
+				surface->shadow_enabled);
 		}
 	}
 }
@@ -22,6 +22,10 @@
 #include "config.h"
 #include "log.h"
 #include "sway/config.h"
+#include "sway/desktop/animation.h"
+#include "sway/desktop/damage_heatmap.h"
+#include "sway/desktop/perf_hud.h"
+#include "sway/desktop/render_profile.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
@@ -30,6 +34,7 @@
 #include "sway/output.h"
 #include "sway/scene_descriptor.h"
 #include "sway/server.h"
+#include "sway/trace.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -232,8 +237,8 @@ void output_configure_scene(struct sway_output *output,
 	if (con) {
 		closest_con = con;
 		opacity = con->alpha;
-		corner_radius = con->corner_radius;
-		blur_enabled = con->blur_enabled;
+		corner_radius = container_get_scaled_corner_radius(con);
+		blur_enabled = con->blur_enabled && !container_effects_culled(con);
 	}
 
 	if (node->type == SWAY_SCENE_NODE_BUFFER) {
@@ -260,29 +265,45 @@ void output_configure_scene(struct sway_output *output,
 		sway_scene_buffer_set_opacity(buffer, opacity);
 
 		// Apply corner radius
-		wlr_scene_buffer_set_corner_radius(buffer,
-			container_has_corner_radius(closest_con) ? corner_radius : 0,
+		bool rounded = container_has_corner_radius(closest_con) && corner_radius > 0;
+		wlr_scene_buffer_set_corner_radius(buffer, rounded ? corner_radius : 0,
 			has_titlebar ? CORNER_LOCATION_BOTTOM : CORNER_LOCATION_ALL);
 
-		// Apply blur
-		wlr_scene_buffer_set_backdrop_blur(buffer, blur_enabled);
-		bool should_optimize_blur = (closest_con &&
-			!container_is_floating_or_child(closest_con)) || config->blur_xray;
-		wlr_scene_buffer_set_backdrop_blur_optimized(buffer, should_optimize_blur);
-
-		// Layer surface blur configuration
+		struct sway_layer_surface *sway_layer = NULL;
 		if (wlr_surface) {
 			struct wlr_layer_surface_v1 *layer_surface =
 				wlr_layer_surface_v1_try_from_wlr_surface(wlr_surface);
-			if (layer_surface && layer_surface->data) {
-				struct sway_layer_surface *sway_layer = layer_surface->data;
-				wlr_scene_buffer_set_backdrop_blur(buffer, sway_layer->blur_enabled);
-				wlr_scene_buffer_set_backdrop_blur_ignore_transparent(buffer,
-					sway_layer->blur_ignore_transparent);
-				wlr_scene_buffer_set_backdrop_blur_optimized(buffer,
-					sway_layer->blur_xray);
+			if (layer_surface) {
+				sway_layer = layer_surface->data;
 			}
 		}
+		bool wants_blur = sway_layer ? sway_layer->blur_enabled : blur_enabled;
+
+		// Backdrop blur only matters where the buffer is see-through: outside
+		// of its opaque region, or in its rounded corners. Buffers that aren't
+		// blurred skip the region math.
+		bool see_through = rounded;
+		if (wants_blur && !see_through) {
+			pixman_region32_t translucent;
+			pixman_region32_init(&translucent);
+			sway_scene_buffer_get_translucent_region(buffer, &translucent);
+			see_through = !pixman_region32_empty(&translucent);
+			pixman_region32_fini(&translucent);
+		}
+
+		// Apply blur
+		wlr_scene_buffer_set_backdrop_blur(buffer, wants_blur && see_through);
+		if (sway_layer) {
+			// Layer surface blur configuration
+			wlr_scene_buffer_set_backdrop_blur_ignore_transparent(buffer,
+				sway_layer->blur_ignore_transparent);
+			wlr_scene_buffer_set_backdrop_blur_optimized(buffer,
+				sway_layer->blur_xray);
+		} else {
+			bool should_optimize_blur = (closest_con &&
+				!container_is_floating_or_child(closest_con)) || config->blur_xray;
+			wlr_scene_buffer_set_backdrop_blur_optimized(buffer, should_optimize_blur);
+		}
 	} else if (node->type == SWAY_SCENE_NODE_TREE) {
 		struct sway_scene_tree *tree = sway_scene_tree_from_node(node);
 		struct sway_scene_node *child;
@@ -310,6 +331,129 @@ static bool output_can_tear(struct sway_output *output) {
 	return false;
 }
 
+static int effects_lod_reduced_outputs = 0;
+static bool effects_lod_animating = false;
+
+void output_effects_lod_set_animating(bool animating) {
+	effects_lod_animating = animating;
+}
+
+bool output_effects_lod_reduced(void) {
+	return effects_lod_reduced_outputs > 0;
+}
+
+static void effects_lod_shadow_iter(struct sway_container *con, void *data) {
+	int *sigma = data;
+	if (!con->shadow) {
+		return;
+	}
+	if (con->view && con->shadow->node.enabled) {
+		struct wlr_box box = {
+			.x = con->shadow->node.x,
+			.y = con->shadow->node.y,
+			.width = con->shadow->width,
+			.height = con->shadow->height,
+		};
+		damage_heatmap_record_shadow(&con->view->scene_tree->node,
+			con->shadow, &box, con->shadow->color, *sigma);
+	}
+	wlr_scene_shadow_set_blur_sigma(con->shadow, *sigma);
+}
+
+static void effects_lod_apply(bool reduced) {
+	struct blur_data blur_data = config->blur_data;
+	int shadow_sigma = config->shadow_blur_sigma;
+	if (reduced) {
+		if (blur_data.num_passes > config->effects_lod.blur_passes) {
+			blur_data.num_passes = config->effects_lod.blur_passes;
+		}
+		shadow_sigma /= 2;
+	}
+	wlr_scene_set_blur_data(root->root_scene, blur_data);
+	sway_scene_set_blur_kernel_size(root->root_scene,
+		blur_data_calc_size(&blur_data));
+	root_for_each_container(effects_lod_shadow_iter, &shadow_sigma);
+
+	struct sway_output *output;
+	wl_list_for_each(output, &root->all_outputs, link) {
+		wlr_scene_optimized_blur_mark_dirty(output->layers.blur_layer);
+	}
+}
+
+void output_apply_effects(void) {
+	effects_lod_apply(output_effects_lod_reduced());
+}
+
+static void output_set_effects_lod_reduced(struct sway_output *output,
+		bool reduced) {
+	if (output->effects_lod.reduced == reduced) {
+		return;
+	}
+	output->effects_lod.reduced = reduced;
+	output->effects_lod.calm_frames = 0;
+
+	bool was_reduced = output_effects_lod_reduced();
+	effects_lod_reduced_outputs += reduced ? 1 : -1;
+	if (was_reduced != output_effects_lod_reduced()) {
+		sway_log(SWAY_DEBUG, "Effects quality %s",
+			reduced ? "reduced" : "restored");
+		effects_lod_apply(reduced);
+	}
+}
+
+static void output_update_effects_lod(struct sway_output *output) {
+	if (!config->effects_lod.enabled) {
+		output_set_effects_lod_reduced(output, false);
+		return;
+	}
+
+	int64_t duration = sway_scene_timer_get_duration_ns(&output->frame_timer);
+	bool over_budget = duration > 0 && output->refresh_nsec > 0 &&
+		duration > config->effects_lod.threshold * output->refresh_nsec;
+
+	struct sway_workspace *ws = output->current.active_workspace;
+	bool motion = effects_lod_animating || (ws && ws->gesture.scrolling);
+
+	if (over_budget || motion) {
+		output_set_effects_lod_reduced(output, true);
+		output->effects_lod.calm_frames = 0;
+	} else if (output->effects_lod.reduced) {
+		if (++output->effects_lod.calm_frames > config->effects_lod.hysteresis) {
+			output_set_effects_lod_reduced(output, false);
+		}
+		// Keep frames coming so full quality returns once motion stops
+		wlr_output_schedule_frame(output->wlr_output);
+	}
+}
+
+// The GPU time of a frame is only known once it has been presented, so the
+// frame timer is read back when the next frame is about to be built.
+// Returns true if a new frame was read.
+static bool output_update_perf_stats(struct sway_output *output) {
+	if (!output->perf.timer_pending) {
+		return false;
+	}
+	output->perf.timer_pending = false;
+
+	struct sway_scene_timer *timer = &output->frame_timer;
+	output->perf.pre_render_ns = timer->pre_render_duration;
+	output->perf.render_ns = timer->render_timer ?
+		wlr_render_timer_get_duration_ns(timer->render_timer) : -1;
+	render_profile_record_gpu(output->wlr_output, output->perf.render_ns);
+	perf_histogram_add(&output->perf.pre_render_hist,
+		output->perf.pre_render_ns / 1000);
+	if (output->perf.render_ns >= 0) {
+		perf_histogram_add(&output->perf.render_hist,
+			output->perf.render_ns / 1000);
+	}
+
+	int64_t duration = sway_scene_timer_get_duration_ns(timer);
+	if (output->refresh_nsec > 0 && duration > output->refresh_nsec) {
+		output->perf.missed_deadlines++;
+	}
+	return true;
+}
+
 static int output_repaint_timer_handler(void *data) {
 	struct sway_output *output = data;
 
@@ -318,26 +462,44 @@ static int output_repaint_timer_handler(void *data) {
 		return 0;
 	}
 
+	bool new_frame = output_update_perf_stats(output);
+	perf_hud_update(output, new_frame);
+	output_update_effects_lod(output);
+
+	trace_begin("output_configure_scene", output->wlr_output->name);
 	output_configure_scene(output, &root->root_scene->tree.node, 1.0f,
 		0, false, false, NULL);
+	trace_end();
 
 	struct sway_scene_output_state_options opts = {
 		.color_transform = output->color_transform,
+		.timer = &output->frame_timer,
 	};
 
 	struct sway_scene_output *scene_output = output->scene_output;
 	if (!sway_scene_output_needs_frame(scene_output)) {
+		output->perf.frames_skipped++;
 		return 0;
 	}
 
+	// Something below the blur layer committed new content or moved; its
+	// pre-blurred copy is stale. Blur parameter changes are handled by
+	// output_apply_effects().
+	if (sway_scene_output_get_blur_damage(scene_output)) {
+		wlr_scene_optimized_blur_mark_dirty(output->layers.blur_layer);
+	}
+
 	struct wlr_output_state pending;
 	wlr_output_state_init(&pending);
 
+	trace_begin("output_build_state", output->wlr_output->name);
 	bool ret = render_workspace_build_state(output, &pending, &opts);
+	trace_end();
 	if (!ret) {
 		wlr_output_state_finish(&pending);
 		return 0;
 	}
+	output->perf.timer_pending = true;
 
 	if (output_can_tear(output)) {
 		pending.tearing_page_flip = true;
@@ -349,9 +511,11 @@ static int output_repaint_timer_handler(void *data) {
 		}
 	}
 
+	trace_begin("output_commit", output->wlr_output->name);
 	if (!wlr_output_commit_state(output->wlr_output, &pending)) {
 		sway_log(SWAY_ERROR, "Page-flip failed on output %s", output->wlr_output->name);
 	}
+	trace_end();
 	wlr_output_state_finish(&pending);
 	return 0;
 }
@@ -413,11 +577,13 @@ static void handle_frame(struct wl_listener *listener, void *user_data) {
 	}
 
 	// Send frame done to all visible surfaces
+	trace_begin("frame_done", output->wlr_output->name);
 	struct send_frame_done_data data = {0};
 	clock_gettime(CLOCK_MONOTONIC, &data.when);
 	data.msec_until_refresh = msec_until_refresh;
 	data.output = output;
 	sway_scene_output_for_each_buffer(output->scene_output, send_frame_done_iterator, &data);
+	trace_end();
 }
 
 void update_output_manager_config(struct sway_server *server) {
@@ -499,6 +665,10 @@ static void begin_destroy(struct sway_output *output) {
 	wl_event_source_remove(output->repaint_timer);
 	output->repaint_timer = NULL;
 
+	output_set_effects_lod_reduced(output, false);
+	sway_scene_timer_finish(&output->frame_timer);
+	perf_hud_destroy(output);
+
 	request_modeset();
 }
 
@@ -522,6 +692,7 @@ static void handle_present(struct wl_listener *listener, void *data) {
 
 	output->last_presentation = output_event->when;
 	output->refresh_nsec = output_event->refresh;
+	trace_instant("page_flip", output->wlr_output->name);
 }
 
 static void handle_request_state(struct wl_listener *listener, void *data) {
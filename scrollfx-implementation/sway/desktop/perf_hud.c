@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <wlr/types/wlr_output.h>
+#include "log.h"
+#include "sway/config.h"
+#include "sway/desktop/perf_hud.h"
+#include "sway/output.h"
+#include "sway/perf.h"
+#include "sway/sway_text_node.h"
+#include "sway/tree/scene.h"
+
+#define PERF_HUD_SAMPLES 120
+#define PERF_HUD_BAR_WIDTH 2
+#define PERF_HUD_GRAPH_HEIGHT 60
+#define PERF_HUD_MARGIN 8
+#define PERF_HUD_TEXT_INTERVAL 30 // samples between text updates
+
+static const float hud_background[4] = { 0.0, 0.0, 0.0, 0.6 };
+static const float hud_cpu_color[4] = { 0.26, 0.52, 0.96, 1.0 };
+static const float hud_gpu_color[4] = { 0.98, 0.62, 0.18, 1.0 };
+static const float hud_cursor_color[4] = { 1.0, 1.0, 1.0, 0.8 };
+static const float hud_text_color[4] = { 1.0, 1.0, 1.0, 1.0 };
+
+struct perf_hud {
+	struct sway_scene_tree *tree;
+	struct sway_scene_rect *background;
+	struct sway_scene_rect *cpu_bars[PERF_HUD_SAMPLES];
+	struct sway_scene_rect *gpu_bars[PERF_HUD_SAMPLES];
+	struct sway_scene_rect *cursor;
+	struct sway_text_node *text;
+
+	int head; // next bar to overwrite
+	int samples_since_text;
+	struct wlr_box box; // logical, relative to the output
+};
+
+static int graph_width(void) {
+	return PERF_HUD_SAMPLES * PERF_HUD_BAR_WIDTH;
+}
+
+static struct perf_hud *perf_hud_create(struct sway_output *output) {
+	struct perf_hud *hud = calloc(1, sizeof(*hud));
+	if (!hud) {
+		sway_log(SWAY_ERROR, "Failed to allocate perf hud");
+		return NULL;
+	}
+
+	hud->tree = sway_scene_tree_create(output->layers.shell_overlay);
+	if (!hud->tree) {
+		free(hud);
+		return NULL;
+	}
+	sway_scene_node_set_position(&hud->tree->node,
+		PERF_HUD_MARGIN, PERF_HUD_MARGIN);
+
+	hud->background = sway_scene_rect_create(hud->tree, graph_width(),
+		PERF_HUD_GRAPH_HEIGHT, hud_background);
+	hud->text = sway_text_node_create(hud->tree, "", (float *)hud_text_color, false);
+	int text_height = hud->text ? hud->text->height : 0;
+	sway_scene_rect_set_size(hud->background, graph_width(),
+		PERF_HUD_GRAPH_HEIGHT + text_height);
+
+	for (int i = 0; i < PERF_HUD_SAMPLES; ++i) {
+		hud->cpu_bars[i] = sway_scene_rect_create(hud->tree,
+			PERF_HUD_BAR_WIDTH, 0, hud_cpu_color);
+		hud->gpu_bars[i] = sway_scene_rect_create(hud->tree,
+			PERF_HUD_BAR_WIDTH, 0, hud_gpu_color);
+		sway_scene_node_set_position(&hud->cpu_bars[i]->node,
+			i * PERF_HUD_BAR_WIDTH, text_height + PERF_HUD_GRAPH_HEIGHT);
+		sway_scene_node_set_position(&hud->gpu_bars[i]->node,
+			i * PERF_HUD_BAR_WIDTH, text_height + PERF_HUD_GRAPH_HEIGHT);
+	}
+
+	hud->cursor = sway_scene_rect_create(hud->tree, 1,
+		PERF_HUD_GRAPH_HEIGHT, hud_cursor_color);
+	sway_scene_node_set_position(&hud->cursor->node, 0, text_height);
+
+	hud->box = (struct wlr_box){
+		.x = PERF_HUD_MARGIN,
+		.y = PERF_HUD_MARGIN,
+		.width = graph_width(),
+		.height = PERF_HUD_GRAPH_HEIGHT + text_height,
+	};
+	return hud;
+}
+
+void perf_hud_destroy(struct sway_output *output) {
+	struct perf_hud *hud = output->perf_hud;
+	if (!hud) {
+		return;
+	}
+
+	sway_scene_node_destroy(&hud->tree->node);
+	free(hud);
+	output->perf_hud = NULL;
+}
+
+// Frames whose only damage was the overlay itself are not sampled, so that
+// drawing the graph neither shows up in it nor keeps the output repainting.
+static bool frame_damaged_only_hud(struct sway_output *output,
+		struct perf_hud *hud) {
+	const pixman_box32_t *extents = &output->scene_output->stats.damage_extents;
+	float scale = output->wlr_output->scale;
+	return extents->x1 >= hud->box.x * scale &&
+		extents->y1 >= hud->box.y * scale &&
+		extents->x2 <= (hud->box.x + hud->box.width) * scale &&
+		extents->y2 <= (hud->box.y + hud->box.height) * scale;
+}
+
+static int bar_height(int64_t nsec, uint32_t refresh_nsec) {
+	// A full-height bar is one refresh period
+	if (nsec <= 0 || refresh_nsec == 0) {
+		return 0;
+	}
+	int64_t height = nsec * PERF_HUD_GRAPH_HEIGHT / refresh_nsec;
+	return height < PERF_HUD_GRAPH_HEIGHT ? height : PERF_HUD_GRAPH_HEIGHT;
+}
+
+static void perf_hud_update_text(struct sway_output *output,
+		struct perf_hud *hud) {
+	if (!hud->text) {
+		return;
+	}
+
+	struct sway_scene_output *scene_output = output->scene_output;
+	int64_t output_area =
+		(int64_t)output->wlr_output->width * output->wlr_output->height;
+	int damage_percent = output_area > 0 ?
+		scene_output->stats.damaged_area * 100 / output_area : 0;
+
+	char text[128];
+	snprintf(text, sizeof(text),
+		"cpu %.2fms gpu %.2fms dmg %d%% list %d txn %.1fms",
+		output->perf.pre_render_ns / 1000000.0,
+		output->perf.render_ns > 0 ? output->perf.render_ns / 1000000.0 : 0.0,
+		damage_percent, scene_output->stats.render_list_len,
+		perf_stats.last_txn_wait_ms);
+	sway_text_node_set_text(hud->text, text);
+	sway_text_node_set_max_width(hud->text, graph_width());
+}
+
+void perf_hud_update(struct sway_output *output, bool new_frame) {
+	if (!config->perf_hud) {
+		perf_hud_destroy(output);
+		return;
+	}
+
+	if (!output->perf_hud) {
+		output->perf_hud = perf_hud_create(output);
+		if (!output->perf_hud) {
+			return;
+		}
+	}
+
+	struct perf_hud *hud = output->perf_hud;
+	if (!new_frame || frame_damaged_only_hud(output, hud)) {
+		return;
+	}
+
+	// Overwrite a single bar and move the cursor, so each sample only
+	// damages two bar-wide columns of the graph
+	int text_height = hud->text ? hud->text->height : 0;
+	int bottom = text_height + PERF_HUD_GRAPH_HEIGHT;
+	int cpu = bar_height(output->perf.pre_render_ns, output->refresh_nsec);
+	int gpu = bar_height(output->perf.render_ns, output->refresh_nsec);
+	if (cpu + gpu > PERF_HUD_GRAPH_HEIGHT) {
+		gpu = PERF_HUD_GRAPH_HEIGHT - cpu;
+	}
+
+	struct sway_scene_rect *cpu_bar = hud->cpu_bars[hud->head];
+	struct sway_scene_rect *gpu_bar = hud->gpu_bars[hud->head];
+	sway_scene_rect_set_size(cpu_bar, PERF_HUD_BAR_WIDTH, cpu);
+	sway_scene_node_set_position(&cpu_bar->node, cpu_bar->node.x, bottom - cpu);
+	sway_scene_rect_set_size(gpu_bar, PERF_HUD_BAR_WIDTH, gpu);
+	sway_scene_node_set_position(&gpu_bar->node, gpu_bar->node.x, bottom - cpu - gpu);
+
+	hud->head = (hud->head + 1) % PERF_HUD_SAMPLES;
+	sway_scene_node_set_position(&hud->cursor->node,
+		hud->head * PERF_HUD_BAR_WIDTH, text_height);
+
+	if (++hud->samples_since_text >= PERF_HUD_TEXT_INTERVAL) {
+		hud->samples_since_text = 0;
+		perf_hud_update_text(output, hud);
+	}
+}
@@ -0,0 +1,365 @@
+#include <json.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wayland-util.h>
+#include <wlr/types/wlr_output.h>
+#include "list.h"
+#include "log.h"
+#include "sway/desktop/render_profile.h"
+#include "sway/perf.h"
+#include "sway/scene_descriptor.h"
+#include "sway/tree/container.h"
+#include "sway/tree/scene.h"
+#include "sway/tree/view.h"
+
+static const char *render_profile_kind_names[RENDER_PROFILE_KIND_COUNT] = {
+	[RENDER_PROFILE_CONTENT] = "content",
+	[RENDER_PROFILE_BLUR] = "blur",
+	[RENDER_PROFILE_CORNERS] = "corners",
+};
+
+struct render_profile_source {
+	char *name;
+	uint64_t entries;
+	int64_t cpu_ns[RENDER_PROFILE_KIND_COUNT];
+	double gpu_ns[RENDER_PROFILE_KIND_COUNT];
+	int64_t pixels[RENDER_PROFILE_KIND_COUNT];
+
+	// Effects of the owning container when it was last sampled
+	bool has_container;
+	bool blur, shadow;
+	int corner_radius;
+	float alpha;
+};
+
+// An entry of the last sampled frame, waiting for the frame's GPU time
+struct render_profile_sample {
+	struct render_profile_source *source;
+	enum render_profile_kind kind;
+	int64_t pixels;
+};
+
+struct render_profile_output {
+	char *name;
+	int frames_left;
+	uint64_t frames, gpu_frames;
+	list_t *sources; // struct render_profile_source *
+
+	bool sampling; // a sampled frame is being built
+	bool gpu_pending; // the last sampled frame has no GPU time yet
+	struct wl_array pending; // struct render_profile_sample
+	int64_t pending_pixels;
+};
+
+static struct {
+	int frames;
+	list_t *outputs; // struct render_profile_output *
+} profile = {0};
+
+static void profile_clear(void) {
+	if (!profile.outputs) {
+		return;
+	}
+	for (int i = 0; i < profile.outputs->length; ++i) {
+		struct render_profile_output *output = profile.outputs->items[i];
+		for (int j = 0; j < output->sources->length; ++j) {
+			struct render_profile_source *source = output->sources->items[j];
+			free(source->name);
+			free(source);
+		}
+		list_free(output->sources);
+		wl_array_release(&output->pending);
+		free(output->name);
+		free(output);
+	}
+	list_free(profile.outputs);
+	profile.outputs = NULL;
+}
+
+void render_profile_start(int frames) {
+	profile_clear();
+	profile.frames = frames;
+	profile.outputs = create_list();
+}
+
+void render_profile_stop(void) {
+	if (!profile.outputs) {
+		return;
+	}
+	for (int i = 0; i < profile.outputs->length; ++i) {
+		struct render_profile_output *output = profile.outputs->items[i];
+		output->frames_left = 0;
+	}
+	profile.frames = 0;
+}
+
+static struct render_profile_output *profile_get_output(struct wlr_output *wlr_output,
+		bool create) {
+	if (!profile.outputs) {
+		return NULL;
+	}
+	for (int i = 0; i < profile.outputs->length; ++i) {
+		struct render_profile_output *output = profile.outputs->items[i];
+		if (strcmp(output->name, wlr_output->name) == 0) {
+			return output;
+		}
+	}
+	if (!create) {
+		return NULL;
+	}
+
+	struct render_profile_output *output = calloc(1, sizeof(*output));
+	if (!output || !(output->name = strdup(wlr_output->name))) {
+		sway_log(SWAY_ERROR, "Failed to allocate render profile");
+		free(output);
+		return NULL;
+	}
+	output->frames_left = profile.frames;
+	output->sources = create_list();
+	wl_array_init(&output->pending);
+	list_add(profile.outputs, output);
+	return output;
+}
+
+static struct sway_container *node_get_container(struct sway_scene_node *node) {
+	for (struct sway_scene_node *it = node; it; it = it->parent ? &it->parent->node : NULL) {
+		struct sway_view *view = scene_descriptor_try_get(it, SWAY_SCENE_DESC_VIEW);
+		if (view) {
+			return view->container;
+		}
+		struct sway_container *con =
+			scene_descriptor_try_get(it, SWAY_SCENE_DESC_CONTAINER);
+		if (con) {
+			return con;
+		}
+	}
+	return NULL;
+}
+
+static struct render_profile_source *output_get_source(
+		struct render_profile_output *output, struct sway_scene_node *node) {
+	char name[128];
+	perf_node_get_source_name(node, name, sizeof(name));
+
+	struct render_profile_source *source = NULL;
+	for (int i = 0; i < output->sources->length; ++i) {
+		struct render_profile_source *it = output->sources->items[i];
+		if (strcmp(it->name, name) == 0) {
+			source = it;
+			break;
+		}
+	}
+	if (!source) {
+		source = calloc(1, sizeof(*source));
+		if (!source || !(source->name = strdup(name))) {
+			sway_log(SWAY_ERROR, "Failed to allocate render profile source");
+			free(source);
+			return NULL;
+		}
+		list_add(output->sources, source);
+	}
+
+	struct sway_container *con = node_get_container(node);
+	if (con) {
+		source->has_container = true;
+		source->blur = con->blur_enabled;
+		source->shadow = container_has_shadow(con);
+		source->corner_radius = container_get_scaled_corner_radius(con);
+		source->alpha = con->alpha;
+	}
+	return source;
+}
+
+static enum render_profile_kind node_get_kind(struct sway_scene_node *node) {
+	if (node->type == SWAY_SCENE_NODE_RECT) {
+		struct sway_scene_rect *rect = sway_scene_rect_from_node(node);
+		if (rect->has_backdrop_blur) {
+			return RENDER_PROFILE_BLUR;
+		}
+		if (rect->corner_radius > 0) {
+			return RENDER_PROFILE_CORNERS;
+		}
+	} else if (node->type == SWAY_SCENE_NODE_BUFFER) {
+		// Windows and layer surfaces, where most of the effects are drawn
+		struct sway_scene_buffer *buffer = sway_scene_buffer_from_node(node);
+		if (buffer->backdrop_blur) {
+			return RENDER_PROFILE_BLUR;
+		}
+		if (buffer->corner_radius > 0) {
+			return RENDER_PROFILE_CORNERS;
+		}
+	}
+	return RENDER_PROFILE_CONTENT;
+}
+
+bool render_profile_frame_begin(struct wlr_output *wlr_output) {
+	if (!profile.outputs || profile.frames <= 0) {
+		return false;
+	}
+	struct render_profile_output *output = profile_get_output(wlr_output, true);
+	if (!output || output->frames_left <= 0) {
+		return false;
+	}
+
+	output->sampling = true;
+	output->gpu_pending = false;
+	output->pending.size = 0;
+	output->pending_pixels = 0;
+	return true;
+}
+
+void render_profile_record_entry(struct wlr_output *wlr_output,
+		struct sway_scene_node *node, int64_t cpu_ns, int64_t pixels) {
+	struct render_profile_output *output = profile_get_output(wlr_output, false);
+	if (!output || !output->sampling) {
+		return;
+	}
+	struct render_profile_source *source = output_get_source(output, node);
+	if (!source) {
+		return;
+	}
+
+	enum render_profile_kind kind = node_get_kind(node);
+	source->entries++;
+	source->cpu_ns[kind] += cpu_ns;
+	source->pixels[kind] += pixels;
+
+	struct render_profile_sample *sample =
+		wl_array_add(&output->pending, sizeof(*sample));
+	if (sample) {
+		*sample = (struct render_profile_sample){
+			.source = source,
+			.kind = kind,
+			.pixels = pixels,
+		};
+		output->pending_pixels += pixels;
+	}
+}
+
+void render_profile_frame_end(struct wlr_output *wlr_output) {
+	struct render_profile_output *output = profile_get_output(wlr_output, false);
+	if (!output || !output->sampling) {
+		return;
+	}
+	output->sampling = false;
+	output->gpu_pending = true;
+	output->frames++;
+	output->frames_left--;
+}
+
+void render_profile_record_gpu(struct wlr_output *wlr_output, int64_t gpu_ns) {
+	struct render_profile_output *output = profile_get_output(wlr_output, false);
+	if (!output || !output->gpu_pending) {
+		return;
+	}
+	output->gpu_pending = false;
+	if (gpu_ns < 0) {
+		return;
+	}
+
+	output->gpu_frames++;
+	if (output->pending_pixels == 0) {
+		return;
+	}
+	struct render_profile_sample *sample;
+	wl_array_for_each(sample, &output->pending) {
+		sample->source->gpu_ns[sample->kind] +=
+			(double)gpu_ns * sample->pixels / output->pending_pixels;
+	}
+}
+
+static double source_cost_per_frame(const struct render_profile_source *source,
+		const struct render_profile_output *output) {
+	double cost = 0;
+	for (int i = 0; i < RENDER_PROFILE_KIND_COUNT; ++i) {
+		cost += output->frames ? (double)source->cpu_ns[i] / output->frames : 0;
+		cost += output->gpu_frames ? source->gpu_ns[i] / output->gpu_frames : 0;
+	}
+	return cost;
+}
+
+// list_qsort has no context argument
+static const struct render_profile_output *sort_output = NULL;
+
+static int cmp_sources_desc(const void *a, const void *b) {
+	const struct render_profile_source *sa = *(void **)a, *sb = *(void **)b;
+	double ca = source_cost_per_frame(sa, sort_output);
+	double cb = source_cost_per_frame(sb, sort_output);
+	return ca < cb ? 1 : ca > cb ? -1 : 0;
+}
+
+static json_object *source_get_json(const struct render_profile_source *source,
+		const struct render_profile_output *output) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "source", json_object_new_string(source->name));
+	json_object_object_add(object, "entries_per_frame", json_object_new_double(
+		output->frames ? (double)source->entries / output->frames : 0));
+
+	double cpu_total = 0, gpu_total = 0;
+	json_object *kinds = json_object_new_object();
+	for (int i = 0; i < RENDER_PROFILE_KIND_COUNT; ++i) {
+		if (source->pixels[i] == 0 && source->cpu_ns[i] == 0) {
+			continue;
+		}
+		double cpu = output->frames ? (double)source->cpu_ns[i] / output->frames : 0;
+		double gpu = output->gpu_frames ? source->gpu_ns[i] / output->gpu_frames : 0;
+		cpu_total += cpu;
+		gpu_total += gpu;
+
+		json_object *kind = json_object_new_object();
+		json_object_object_add(kind, "cpu_us_per_frame",
+			json_object_new_double(cpu / 1000));
+		json_object_object_add(kind, "gpu_us_per_frame",
+			json_object_new_double(gpu / 1000));
+		json_object_object_add(kind, "pixels_per_frame", json_object_new_int64(
+			output->frames ? source->pixels[i] / (int64_t)output->frames : 0));
+		json_object_object_add(kinds, render_profile_kind_names[i], kind);
+	}
+	json_object_object_add(object, "cpu_us_per_frame",
+		json_object_new_double(cpu_total / 1000));
+	json_object_object_add(object, "gpu_us_per_frame",
+		json_object_new_double(gpu_total / 1000));
+	json_object_object_add(object, "by_kind", kinds);
+
+	if (source->has_container) {
+		json_object *effects = json_object_new_object();
+		json_object_object_add(effects, "blur", json_object_new_boolean(source->blur));
+		json_object_object_add(effects, "shadow",
+			json_object_new_boolean(source->shadow));
+		json_object_object_add(effects, "corner_radius",
+			json_object_new_int(source->corner_radius));
+		json_object_object_add(effects, "opacity",
+			json_object_new_double(source->alpha));
+		json_object_object_add(object, "effects", effects);
+	}
+	return object;
+}
+
+json_object *render_profile_get_json(void) {
+	json_object *object = json_object_new_object();
+	json_object *outputs = json_object_new_array();
+	for (int i = 0; profile.outputs && i < profile.outputs->length; ++i) {
+		struct render_profile_output *output = profile.outputs->items[i];
+		json_object *entry = json_object_new_object();
+		json_object_object_add(entry, "name", json_object_new_string(output->name));
+		json_object_object_add(entry, "frames", json_object_new_int64(output->frames));
+		json_object_object_add(entry, "gpu_frames",
+			json_object_new_int64(output->gpu_frames));
+		json_object_object_add(entry, "frames_left",
+			json_object_new_int(output->frames_left > 0 ? output->frames_left : 0));
+
+		sort_output = output;
+		list_qsort(output->sources, cmp_sources_desc);
+		sort_output = NULL;
+
+		json_object *sources = json_object_new_array();
+		for (int j = 0; j < output->sources->length; ++j) {
+			json_object_array_add(sources,
+				source_get_json(output->sources->items[j], output));
+		}
+		json_object_object_add(entry, "sources", sources);
+		json_object_array_add(outputs, entry);
+	}
+	json_object_object_add(object, "outputs", outputs);
+	return object;
+}
@@ -5,18 +5,23 @@
 #include <wlr/types/wlr_buffer.h>
 #include "sway/config.h"
 #include "sway/scene_descriptor.h"
+#include "sway/desktop/damage_heatmap.h"
 #include "sway/desktop/idle_inhibit_v1.h"
 #include "sway/desktop/transaction.h"
 #include "sway/desktop/animation.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
+#include "sway/mem_stats.h"
 #include "sway/output.h"
+#include "sway/perf.h"
+#include "sway/replay.h"
 #include "sway/server.h"
 #include "sway/tree/container.h"
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "sway/tree/layout.h"
+#include "sway/trace.h"
 #include "list.h"
 #include "log.h"
 #include "util.h"
@@ -48,6 +53,7 @@ static struct sway_transaction *transaction_create(void) {
 	if (!sway_assert(transaction, "Unable to allocate transaction")) {
 		return NULL;
 	}
+	mem_account_alloc(MEM_TRANSACTION, sizeof(struct sway_transaction));
 	transaction->instructions = create_list();
 	return transaction;
 }
@@ -78,6 +84,8 @@ static void transaction_destroy(struct sway_transaction *transaction) {
 				break;
 			}
 		}
+		mem_account_free(MEM_TRANSACTION,
+			sizeof(struct sway_transaction_instruction));
 		free(instruction);
 	}
 	list_free(transaction->instructions);
@@ -85,6 +93,7 @@ static void transaction_destroy(struct sway_transaction *transaction) {
 	if (transaction->timer) {
 		wl_event_source_remove(transaction->timer);
 	}
+	mem_account_free(MEM_TRANSACTION, sizeof(struct sway_transaction));
 	free(transaction);
 }
 
@@ -188,6 +197,8 @@ static void transaction_add_node(struct sway_transaction *transaction,
 		if (!sway_assert(instruction, "Unable to allocate instruction")) {
 			return;
 		}
+		mem_account_alloc(MEM_TRANSACTION,
+			sizeof(struct sway_transaction_instruction));
 		instruction->transaction = transaction;
 		instruction->node = node;
 		instruction->server_request = server_request;
@@ -955,19 +966,32 @@ static void arrange_container(struct sway_container *con,
 		}
 #endif
 
-		// Shadow management
-		if (container_has_shadow(con)) {
+		// Shadow management, skipped when the container is scaled too far down
+		bool has_shadow = container_has_shadow(con) && !container_effects_culled(con);
+		if (has_shadow) {
 			bool has_corner_radius = container_has_corner_radius(con);
 			int corner_radius = has_corner_radius ?
-				con->corner_radius + con->current.border_thickness : 0;
+				round(scale * (con->corner_radius + con->current.border_thickness)) : 0;
+
+			struct wlr_box shadow_box = {
+				.x = con->current.x - config->shadow_blur_sigma + config->shadow_offset_x,
+				.y = con->current.y - config->shadow_blur_sigma + config->shadow_offset_y,
+				.width = width + config->shadow_blur_sigma * 2,
+				.height = height + config->shadow_blur_sigma * 2,
+			};
+			float *color = con->current.focused || con->current.urgent ?
+				config->shadow_color : config->shadow_inactive_color;
+			// Keep the cheaper shadow while effects are reduced
+			int blur_sigma = output_effects_lod_reduced() ?
+				config->shadow_blur_sigma / 2 : config->shadow_blur_sigma;
+			damage_heatmap_record_shadow(&con->view->scene_tree->node,
+				con->shadow, &shadow_box, color, blur_sigma);
 
 			wlr_scene_shadow_set_size(con->shadow,
-				width + config->shadow_blur_sigma * 2,
-				height + config->shadow_blur_sigma * 2);
+				shadow_box.width, shadow_box.height);
 
 			wlr_scene_node_set_position(&con->shadow->node,
-				con->current.x - config->shadow_blur_sigma + config->shadow_offset_x,
-				con->current.y - config->shadow_blur_sigma + config->shadow_offset_y);
+				shadow_box.x, shadow_box.y);
 
 			wlr_scene_shadow_set_clipped_region(con->shadow, (struct clipped_region) {
 				.corner_radius = corner_radius,
@@ -980,12 +1004,11 @@ static void arrange_container(struct sway_container *con,
 				},
 			});
 
-			float *color = con->current.focused || con->current.urgent ?
-				config->shadow_color : config->shadow_inactive_color;
 			wlr_scene_shadow_set_color(con->shadow, color);
-			wlr_scene_shadow_set_blur_sigma(con->shadow, config->shadow_blur_sigma);
+			wlr_scene_shadow_set_blur_sigma(con->shadow, blur_sigma);
 			wlr_scene_shadow_set_corner_radius(con->shadow, corner_radius);
 		}
+		wlr_scene_node_set_enabled(&con->shadow->node, has_shadow);
 
 		view_reconfigure(con->view);
 	} else {
@@ -1210,6 +1233,8 @@ void arrange_popups(struct sway_scene_tree *popups) {
 static void arrange_root(struct sway_root *root) {
 	struct sway_container *fs = root->fullscreen_global;
 
+	trace_begin("arrange_root", NULL);
+
 	sway_scene_node_set_enabled(&root->layers.shell_background->node, !fs);
 	sway_scene_node_set_enabled(&root->layers.shell_bottom->node, !fs);
 	// Disable blur layer during fullscreen
@@ -1289,6 +1314,7 @@ static void arrange_root(struct sway_root *root) {
 	}
 
 	arrange_popups(root->layers.popup);
+	trace_end();
 }
 
 /**
@@ -1296,16 +1322,19 @@ static void arrange_root(struct sway_root *root) {
  */
 static void transaction_apply(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Applying transaction %p", transaction);
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	struct timespec *commit = &transaction->commit_time;
+	float ms = (now.tv_sec - commit->tv_sec) * 1000 +
+		(now.tv_nsec - commit->tv_nsec) / 1000000.0;
+	perf_record_txn_wait(ms);
 	if (debug.txn_timings) {
-		struct timespec now;
-		clock_gettime(CLOCK_MONOTONIC, &now);
-		struct timespec *commit = &transaction->commit_time;
-		float ms = (now.tv_sec - commit->tv_sec) * 1000 +
-			(now.tv_nsec - commit->tv_nsec) / 1000000.0;
 		sway_log(SWAY_DEBUG, "Transaction %p: %.1fms waiting "
 				"(%.1f frames if 60Hz)", transaction, ms, ms / (1000.0f / 60));
 	}
 
+	trace_begin("transaction_apply", NULL);
+
 	// Apply the instruction state to the node's current state
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
@@ -1330,6 +1359,8 @@ static void transaction_apply(struct sway_transaction *transaction) {
 
 		node->instruction = NULL;
 	}
+
+	trace_end();
 }
 
 static void animation_arrange_children(struct sway_workspace *workspace,
@@ -1403,10 +1434,12 @@ static void animation_arrange_children(struct sway_workspace *workspace,
 }
 
 static void animation_callback(void *data) {
+	output_effects_lod_set_animating(true);
 	arrange_root(root);
 }
 
 static void animation_callback_end(void *data) {
+	output_effects_lod_set_animating(false);
 	cursor_rebase_all();
 }
 
@@ -1464,6 +1497,17 @@ static int handle_timeout(void *data) {
 	struct sway_transaction *transaction = data;
 	sway_log(SWAY_DEBUG, "Transaction %p timed out (%zi waiting)",
 			transaction, transaction->num_waiting);
+	perf_stats.txn_timeouts++;
+	// Blame the views that still have not acked their configure
+	for (int i = 0; i < transaction->instructions->length; ++i) {
+		struct sway_transaction_instruction *instruction =
+			transaction->instructions->items[i];
+		struct sway_node *node = instruction->node;
+		if (instruction->waiting && node->instruction == instruction &&
+				!node->destroying) {
+			perf_record_configure_timeout(node->sway_container->view);
+		}
+	}
 	transaction->num_waiting = 0;
 	transaction_progress();
 	return 0;
@@ -1506,6 +1550,7 @@ static bool should_configure(struct sway_node *node,
 static void transaction_commit(struct sway_transaction *transaction) {
 	sway_log(SWAY_DEBUG, "Transaction %p committing with %i instructions",
 			transaction, transaction->instructions->length);
+	trace_begin("transaction_commit", NULL);
 	transaction->num_waiting = 0;
 	for (int i = 0; i < transaction->instructions->length; ++i) {
 		struct sway_transaction_instruction *instruction =
@@ -1519,6 +1564,9 @@ static void transaction_commit(struct sway_transaction *transaction) {
 					instruction->container_state.content_y,
 					instruction->container_state.content_width,
 					instruction->container_state.content_height);
+			replay_record_configure(node->sway_container->view,
+					instruction->container_state.content_width,
+					instruction->container_state.content_height);
 			if (!hidden) {
 				instruction->waiting = true;
 				++transaction->num_waiting;
@@ -1533,9 +1581,7 @@ static void transaction_commit(struct sway_transaction *transaction) {
 		node->instruction = instruction;
 	}
 	transaction->num_configures = transaction->num_waiting;
-	if (debug.txn_timings) {
-		clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
-	}
+	clock_gettime(CLOCK_MONOTONIC, &transaction->commit_time);
 	if (debug.noatomic) {
 		transaction->num_waiting = 0;
 	} else if (debug.txn_wait) {
@@ -1557,6 +1603,7 @@ static void transaction_commit(struct sway_transaction *transaction) {
 			transaction->num_waiting = 0;
 		}
 	}
+	trace_end();
 }
 
 static void transaction_commit_pending(void) {
@@ -1574,17 +1621,30 @@ static void set_instruction_ready(
 		struct sway_transaction_instruction *instruction) {
 	struct sway_transaction *transaction = instruction->transaction;
 
-	if (debug.txn_timings) {
+	if (instruction->waiting || debug.txn_timings) {
 		struct timespec now;
 		clock_gettime(CLOCK_MONOTONIC, &now);
 		struct timespec *start = &transaction->commit_time;
 		float ms = (now.tv_sec - start->tv_sec) * 1000 +
 			(now.tv_nsec - start->tv_nsec) / 1000000.0;
-		sway_log(SWAY_DEBUG, "Transaction %p: %zi/%zi ready in %.1fms (%s)",
-				transaction,
-				transaction->num_configures - transaction->num_waiting + 1,
-				transaction->num_configures, ms,
-				instruction->node->sway_container->title);
+		if (instruction->waiting) {
+			perf_record_configure_ack(instruction->node->sway_container->view,
+				ms * 1000);
+		}
+		if (debug.txn_timings) {
+			sway_log(SWAY_DEBUG, "Transaction %p: %zi/%zi ready in %.1fms (%s)",
+					transaction,
+					transaction->num_configures - transaction->num_waiting + 1,
+					transaction->num_configures, ms,
+					instruction->node->sway_container->title);
+		}
+	}
+
+	replay_record_configure_ack(instruction->node->sway_container->view);
+
+	if (trace_enabled()) {
+		trace_instant("transaction_ready",
+			instruction->node->sway_container->title);
 	}
 
 	// If the transaction has timed out then its num_waiting will be 0 already.
@@ -1663,7 +1723,18 @@ static void save_animation_variables() {
 	}
 }
 
+// Commits asked for while deferred, made by transaction_defer_end()
+static struct {
+	int depth;
+	bool pending, server_request;
+} deferred = {0};
+
 static void _transaction_commit_dirty(bool server_request) {
+	if (deferred.depth > 0) {
+		deferred.pending = true;
+		deferred.server_request |= server_request;
+		return;
+	}
 	if (!server.dirty_nodes->length) {
 		return;
 	}
@@ -1695,3 +1766,20 @@ void transaction_commit_dirty(void) {
 void transaction_commit_dirty_client(void) {
 	_transaction_commit_dirty(false);
 }
+
+void transaction_defer_begin(void) {
+	deferred.depth++;
+}
+
+void transaction_defer_end(void) {
+	if (!sway_assert(deferred.depth > 0, "Unbalanced transaction_defer_end")) {
+		return;
+	}
+	if (--deferred.depth > 0 || !deferred.pending) {
+		return;
+	}
+	bool server_request = deferred.server_request;
+	deferred.pending = false;
+	deferred.server_request = false;
+	_transaction_commit_dirty(server_request);
+}
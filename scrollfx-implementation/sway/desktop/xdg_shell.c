@@ -13,6 +13,7 @@
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/output.h"
+#include "sway/replay.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
 #include "sway/tree/root.h"
@@ -303,6 +304,8 @@ static void handle_commit(struct wl_listener *listener, void *data) {
 		return;
 	}
 
+	replay_record_commit(view, xdg_surface->surface);
+
 	struct wlr_box *new_geo = &xdg_surface->geometry;
 	bool new_size = new_geo->width != view->geometry.width ||
 			new_geo->height != view->geometry.height ||
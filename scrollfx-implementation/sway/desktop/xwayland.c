@@ -10,11 +10,13 @@
 #include <scenefx/types/wlr_scene.h>
 #include "log.h"
 #include "sway/config.h"
+#include "sway/criteria_index.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/output.h"
+#include "sway/replay.h"
 #include "sway/scene_descriptor.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
@@ -56,17 +58,6 @@ static void unmanaged_handle_set_geometry(struct wl_listener *listener, void *da
 	sway_scene_node_set_position(&surface->surface_scene->buffer->node, xsurface->x, xsurface->y);
 }
 
-static bool find_container_by_pid(struct sway_container *con, void *data) {
-	if (con && con->view) {
-		pid_t *pid = data;
-		struct sway_view *view = con->view;
-		if (view->pid == *pid) {
-			return true;
-		}
-	}
-	return false;
-}
-
 static void get_node_coords(struct wlr_xwayland_surface *xsurface, double *dx, double *dy) {
 	double x, y;
 	struct sway_view *view = view_from_wlr_xwayland_surface(xsurface);
@@ -74,10 +65,9 @@ static void get_node_coords(struct wlr_xwayland_surface *xsurface, double *dx, d
 	if (!view || !view->container) {
 		// We could be here if an unmanaged surface (a tooltip for example) is
 		// created without a parent view. Try to find the "parent" by checking PIDs
-		pid_t pid = xsurface->pid;
-		struct sway_container *con = root_find_container(find_container_by_pid, &pid);
-		if (con && con->view) {
-			view = con->view;
+		struct sway_view *parent = root_find_view_by_pid(xsurface->pid);
+		if (parent) {
+			view = parent;
 		}
 	}
 
@@ -338,15 +328,99 @@ static uint32_t get_int_prop(struct sway_view *view, enum sway_view_prop prop) {
 	}
 }
 
+struct pending_configure {
+	struct sway_view *view; // NULL once the view is destroyed
+	int x, y, width, height;
+};
+
+// Views can be configured several times while a transaction is committed and
+// its containers arranged. Only the last geometry of each is sent, once per
+// event loop iteration.
+static struct {
+	struct wl_array configures; // struct pending_configure
+	struct wl_array flushing; // struct pending_configure
+	struct wl_event_source *idle;
+} pending;
+
+static void pending_configure_cancel(struct wl_array *configures,
+		struct sway_view *view) {
+	struct pending_configure *configure;
+	wl_array_for_each(configure, configures) {
+		if (configure->view == view) {
+			configure->view = NULL;
+		}
+	}
+}
+
+static void handle_configure_idle(void *data) {
+	pending.idle = NULL;
+
+	// Views configured from here on, by a transaction that the loop below
+	// lets through, get a new pass
+	struct wl_array swap = pending.flushing;
+	pending.flushing = pending.configures;
+	pending.configures = swap;
+	pending.configures.size = 0;
+
+	struct pending_configure *configure;
+	wl_array_for_each(configure, &pending.flushing) {
+		struct sway_view *view = configure->view;
+		if (view == NULL || view->wlr_xwayland_surface == NULL) {
+			continue;
+		}
+		struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
+		if (xsurface->x != configure->x || xsurface->y != configure->y ||
+				xsurface->width != configure->width ||
+				xsurface->height != configure->height) {
+			wlr_xwayland_surface_configure(xsurface, configure->x,
+				configure->y, configure->width, configure->height);
+			continue;
+		}
+
+		// The client already has this geometry and does not answer a
+		// repeated configure, so don't make the transaction wait for it
+		if (xsurface->surface && xsurface->surface->mapped &&
+				view->container && view->container->node.instruction) {
+			struct wlr_surface_state *state = &xsurface->surface->current;
+			transaction_notify_view_ready_by_geometry(view,
+				xsurface->x, xsurface->y, state->width, state->height);
+		}
+	}
+	pending.flushing.size = 0;
+}
+
 static uint32_t configure(struct sway_view *view, double lx, double ly, int width,
 		int height) {
 	struct sway_xwayland_view *xwayland_view = xwayland_view_from_view(view);
 	if (xwayland_view == NULL) {
 		return 0;
 	}
-	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
 
-	wlr_xwayland_surface_configure(xsurface, lx, ly, width, height);
+	struct pending_configure *configure = NULL, *iter;
+	wl_array_for_each(iter, &pending.configures) {
+		if (iter->view == view) {
+			configure = iter;
+			break;
+		}
+	}
+	if (configure == NULL) {
+		configure = wl_array_add(&pending.configures, sizeof(*configure));
+		if (configure == NULL) {
+			wlr_xwayland_surface_configure(view->wlr_xwayland_surface,
+				lx, ly, width, height);
+			return 0;
+		}
+		configure->view = view;
+	}
+	configure->x = lx;
+	configure->y = ly;
+	configure->width = width;
+	configure->height = height;
+
+	if (pending.idle == NULL) {
+		pending.idle = wl_event_loop_add_idle(server.wl_event_loop,
+			handle_configure_idle, NULL);
+	}
 
 	// xwayland doesn't give us a serial for the configure
 	return 0;
@@ -450,6 +524,8 @@ static void destroy(struct sway_view *view) {
 	if (xwayland_view == NULL) {
 		return;
 	}
+	pending_configure_cancel(&pending.configures, view);
+	pending_configure_cancel(&pending.flushing, view);
 	free(xwayland_view);
 }
 
@@ -493,6 +569,8 @@ static void handle_commit(struct wl_listener *listener, void *data) {
 	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
 	struct wlr_surface_state *state = &xsurface->surface->current;
 
+	replay_record_commit(view, xsurface->surface);
+
 	struct wlr_box new_geo = {0};
 	new_geo.width = state->width;
 	new_geo.height = state->height;
@@ -652,6 +730,7 @@ static void handle_request_configure(struct wl_listener *listener, void *data) {
 	struct sway_view *view = &xwayland_view->view;
 	struct wlr_xwayland_surface *xsurface = view->wlr_xwayland_surface;
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
+		pending_configure_cancel(&pending.configures, view);
 		wlr_xwayland_surface_configure(xsurface, ev->x, ev->y,
 			ev->width, ev->height);
 		return;
@@ -789,6 +868,7 @@ static void handle_set_class(struct wl_listener *listener, void *data) {
 	if (xsurface->surface == NULL || !xsurface->surface->mapped) {
 		return;
 	}
+	criteria_index_update_view(view);
 	view_execute_criteria(view);
 }
 
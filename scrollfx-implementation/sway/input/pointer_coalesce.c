@@ -0,0 +1,47 @@
+#include "sway/config.h"
+#include "sway/input/pointer_coalesce.h"
+
+static void coalesce_apply(void *data) {
+	struct pointer_coalesce *coalesce = data;
+	double dx = coalesce->dx, dy = coalesce->dy;
+	coalesce->dx = coalesce->dy = 0;
+	coalesce->apply(coalesce, coalesce->time_msec, coalesce->device, dx, dy);
+}
+
+void pointer_coalesce_init(struct pointer_coalesce *coalesce,
+		struct wlr_cursor *cursor, pointer_coalesce_apply_func_t apply) {
+	*coalesce = (struct pointer_coalesce){
+		.apply = apply,
+	};
+	refresh_throttle_init(&coalesce->throttle, cursor, coalesce_apply, coalesce);
+}
+
+void pointer_coalesce_finish(struct pointer_coalesce *coalesce) {
+	refresh_throttle_finish(&coalesce->throttle);
+}
+
+bool pointer_coalesce_motion(struct pointer_coalesce *coalesce,
+		uint32_t time_msec, struct wlr_input_device *device, double dx, double dy) {
+	if (!config->pointer_coalesce) {
+		pointer_coalesce_flush(coalesce);
+		return false;
+	}
+	if (coalesce->throttle.pending && coalesce->device != device) {
+		// Keep motion attributed to the device that made it
+		pointer_coalesce_flush(coalesce);
+	}
+	if (refresh_throttle_request(&coalesce->throttle)) {
+		// First motion of this frame, the caller applies it right away
+		return false;
+	}
+
+	coalesce->time_msec = time_msec;
+	coalesce->device = device;
+	coalesce->dx += dx;
+	coalesce->dy += dy;
+	return true;
+}
+
+void pointer_coalesce_flush(struct pointer_coalesce *coalesce) {
+	refresh_throttle_flush(&coalesce->throttle);
+}
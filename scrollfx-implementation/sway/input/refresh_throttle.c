@@ -0,0 +1,80 @@
+#include <wlr/types/wlr_cursor.h>
+#include <wlr/types/wlr_output.h>
+#include <wlr/types/wlr_output_layout.h>
+#include "log.h"
+#include "sway/input/refresh_throttle.h"
+#include "sway/server.h"
+#include "sway/tree/root.h"
+
+// Refresh period of the output under the cursor
+static int period_msec(struct refresh_throttle *throttle) {
+	struct wlr_output *wlr_output = wlr_output_layout_output_at(
+		root->output_layout, throttle->cursor->x, throttle->cursor->y);
+	if (!wlr_output || wlr_output->refresh <= 0) {
+		return 16;
+	}
+	// refresh is in mHz
+	int delay = 1000000 / wlr_output->refresh;
+	return delay > 0 ? delay : 1;
+}
+
+static int handle_timer(void *data) {
+	struct refresh_throttle *throttle = data;
+	if (!throttle->pending) {
+		throttle->armed = false;
+		return 0;
+	}
+	throttle->pending = false;
+	throttle->func(throttle->data);
+	wl_event_source_timer_update(throttle->timer, period_msec(throttle));
+	return 0;
+}
+
+bool refresh_throttle_init(struct refresh_throttle *throttle,
+		struct wlr_cursor *cursor, refresh_throttle_func_t func, void *data) {
+	*throttle = (struct refresh_throttle){
+		.cursor = cursor,
+		.func = func,
+		.data = data,
+	};
+	throttle->timer = wl_event_loop_add_timer(server.wl_event_loop,
+		handle_timer, throttle);
+	if (!throttle->timer) {
+		sway_log(SWAY_ERROR, "Unable to create refresh throttle timer");
+		return false;
+	}
+	return true;
+}
+
+void refresh_throttle_finish(struct refresh_throttle *throttle) {
+	if (throttle->timer) {
+		wl_event_source_remove(throttle->timer);
+		throttle->timer = NULL;
+	}
+	throttle->armed = throttle->pending = false;
+}
+
+bool refresh_throttle_request(struct refresh_throttle *throttle) {
+	if (!throttle->timer) {
+		return true;
+	}
+	if (!throttle->armed) {
+		throttle->armed = true;
+		wl_event_source_timer_update(throttle->timer, period_msec(throttle));
+		return true;
+	}
+	throttle->pending = true;
+	return false;
+}
+
+bool refresh_throttle_cancel(struct refresh_throttle *throttle) {
+	bool pending = throttle->pending;
+	throttle->pending = false;
+	return pending;
+}
+
+void refresh_throttle_flush(struct refresh_throttle *throttle) {
+	if (refresh_throttle_cancel(throttle)) {
+		throttle->func(throttle->data);
+	}
+}
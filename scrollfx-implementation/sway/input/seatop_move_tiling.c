@@ -3,9 +3,11 @@
 #include <wlr/util/edges.h>
 #include "sway/desktop/transaction.h"
 #include "sway/input/cursor.h"
+#include "sway/input/refresh_throttle.h"
 #include "sway/input/seat.h"
 #include "sway/ipc-server.h"
 #include "sway/output.h"
+#include "sway/server.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/node.h"
 #include "sway/tree/view.h"
@@ -25,12 +27,32 @@ struct seatop_move_tiling_event {
 	bool threshold_reached;
 	bool insert_after_target;
 	struct sway_scene_rect *indicator_rect;
+	struct wlr_box indicator_box; // last box shown by update_indicator()
+
+	// Motion after the threshold is handled at most once per output frame
+	struct refresh_throttle motion;
+
+	// Drop zones of the container last hit, valid while its box and the
+	// geometry of its workspace are unchanged
+	struct {
+		struct sway_node *node; // hit-test result
+		struct sway_container *con; // drop target, may be node's parent
+		struct wlr_box node_box; // node_get_box() when cached
+		double ws_x, ws_y;
+		int ws_gaps_inner;
+		float ws_scale;
+		bool denied;
+		int thresh_top, thresh_bottom, thresh_left, thresh_right;
+		int drop_layout_border;
+		struct wlr_box box;
+	} hit;
 };
 
 static void handle_end(struct sway_seat *seat) {
 	struct seatop_move_tiling_event *e = seat->seatop_data;
 	sway_scene_node_destroy(&e->indicator_rect->node);
 	e->indicator_rect = NULL;
+	refresh_throttle_finish(&e->motion);
 }
 
 static void handle_motion_prethreshold(struct sway_seat *seat) {
@@ -58,6 +80,7 @@ static void handle_motion_prethreshold(struct sway_seat *seat) {
 }
 
 static void update_indicator(struct seatop_move_tiling_event *e, struct wlr_box *box) {
+	e->indicator_box = *box;
 	sway_scene_node_set_position(&e->indicator_rect->node, box->x, box->y);
 	sway_scene_rect_set_size(e->indicator_rect, box->width, box->height);
 
@@ -79,50 +102,38 @@ static void update_indicator(struct seatop_move_tiling_event *e, struct wlr_box
 	sway_scene_rect_set_corner_radius(e->indicator_rect, corner_radius, CORNER_LOCATION_ALL);
 }
 
-static void handle_motion_postthreshold(struct sway_seat *seat) {
-	struct seatop_move_tiling_event *e = seat->seatop_data;
-	struct wlr_surface *surface = NULL;
-	double sx, sy;
-	struct sway_cursor *cursor = seat->cursor;
-	struct sway_node *node = node_at_coords(seat,
-			cursor->cursor->x, cursor->cursor->y, &surface, &sx, &sy);
+static void set_target(struct seatop_move_tiling_event *e,
+		struct sway_node *target, enum wlr_edges edge) {
+	e->target_node = target;
+	e->target_edge = edge;
+}
 
-	if (!node) {
-		// Eg. hovered over a layer surface such as swaybar
-		e->target_node = NULL;
-		e->target_edge = WLR_EDGE_NONE;
-		return;
-	}
-	if (node->type == N_WORKSPACE) {
-		// Empty workspace
-		e->target_node = node;
-		e->target_edge = WLR_EDGE_NONE;
+static float workspace_scale(struct sway_workspace *workspace) {
+	return layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0f;
+}
 
-		struct wlr_box drop_box;
-		workspace_get_box(node->sway_workspace, &drop_box);
-		update_indicator(e, &drop_box);
-		return;
-	}
-	struct sway_container *con = node->sway_container;
-	// If tiling container, exit
-	if (container_is_floating(con)) {
-		e->target_node = NULL;
-		e->target_edge = WLR_EDGE_NONE;
-		return;
-	}
+// Computes the drop zones of con, which was hit at node
+static void hit_cache_fill(struct seatop_move_tiling_event *e,
+		struct sway_node *node, struct sway_container *con) {
+	e->hit.node = node;
+	node_get_box(node, &e->hit.node_box);
+	struct sway_workspace *hit_workspace = con->pending.workspace;
+	e->hit.ws_x = hit_workspace->x;
+	e->hit.ws_y = hit_workspace->y;
+	e->hit.ws_gaps_inner = hit_workspace->gaps_inner;
+	e->hit.ws_scale = workspace_scale(hit_workspace);
 	// Deny moving within own workspace if this is the only child
-	if (workspace_num_tiling_views(e->con->pending.workspace) == 1 &&
-			con->pending.workspace == e->con->pending.workspace) {
-		e->target_node = NULL;
-		e->target_edge = WLR_EDGE_NONE;
+	e->hit.denied = workspace_num_tiling_views(e->con->pending.workspace) == 1 &&
+		con->pending.workspace == e->con->pending.workspace;
+	if (e->hit.denied) {
 		return;
 	}
+
 	struct sway_workspace *old_workspace = e->con->pending.workspace;
 	bool move_parent = layout_get_type(old_workspace) == layout_modifiers_get_mode(old_workspace);
 	struct sway_workspace *workspace = con->pending.workspace;
 	enum sway_container_layout layout = layout_get_type(workspace);
-	struct wlr_box node_box;
-	node_get_box(&con->node, &node_box);
+	struct wlr_box node_box = e->hit.node_box;
 	node_box.x -= workspace->x;
 	node_box.y -= workspace->y;
 	int drop_layout_border = DROP_LAYOUT_BORDER;
@@ -160,22 +171,81 @@ static void handle_motion_postthreshold(struct sway_seat *seat) {
 	node_box.y += gap_y;
 	box.x += gap_x;
 	box.y += gap_y;
+
+	e->hit.con = con;
+	e->hit.box = box;
+	e->hit.drop_layout_border = drop_layout_border;
+	e->hit.thresh_top = node_box.y + drop_layout_border;
+	e->hit.thresh_bottom = node_box.y + node_box.height - drop_layout_border;
+	e->hit.thresh_left = node_box.x + drop_layout_border;
+	e->hit.thresh_right = node_box.x + node_box.width - drop_layout_border;
+}
+
+static bool hit_cache_valid(struct seatop_move_tiling_event *e,
+		struct sway_node *node) {
+	if (e->hit.node != node) {
+		return false;
+	}
+	struct wlr_box node_box;
+	node_get_box(node, &node_box);
+	struct sway_workspace *workspace = node->sway_container->pending.workspace;
+	return wlr_box_equal(&node_box, &e->hit.node_box) &&
+		workspace->x == e->hit.ws_x && workspace->y == e->hit.ws_y &&
+		workspace->gaps_inner == e->hit.ws_gaps_inner &&
+		workspace_scale(workspace) == e->hit.ws_scale;
+}
+
+static void handle_motion_postthreshold(struct sway_seat *seat) {
+	struct seatop_move_tiling_event *e = seat->seatop_data;
+	struct wlr_surface *surface = NULL;
+	double sx, sy;
+	struct sway_cursor *cursor = seat->cursor;
+	struct sway_node *node = node_at_coords(seat,
+			cursor->cursor->x, cursor->cursor->y, &surface, &sx, &sy);
+
+	if (!node) {
+		// Eg. hovered over a layer surface such as swaybar
+		set_target(e, NULL, WLR_EDGE_NONE);
+		return;
+	}
+	if (node->type == N_WORKSPACE) {
+		// Empty workspace
+		struct wlr_box drop_box;
+		workspace_get_box(node->sway_workspace, &drop_box);
+		if (e->target_node != node || !wlr_box_equal(&drop_box, &e->indicator_box)) {
+			set_target(e, node, WLR_EDGE_NONE);
+			update_indicator(e, &drop_box);
+		}
+		return;
+	}
+	struct sway_container *con = node->sway_container;
+	// If tiling container, exit
+	if (container_is_floating(con)) {
+		set_target(e, NULL, WLR_EDGE_NONE);
+		return;
+	}
+	if (!hit_cache_valid(e, node)) {
+		hit_cache_fill(e, node, con);
+	}
+	if (e->hit.denied) {
+		set_target(e, NULL, WLR_EDGE_NONE);
+		return;
+	}
+
 	enum wlr_edges edge = WLR_EDGE_NONE;
-	int thresh_top = node_box.y + drop_layout_border;
-	int thresh_bottom = node_box.y + node_box.height - drop_layout_border;
-	int thresh_left = node_box.x + drop_layout_border;
-	int thresh_right = node_box.x + node_box.width - drop_layout_border;
-	if (cursor->cursor->y < thresh_top) {
+	int drop_layout_border = e->hit.drop_layout_border;
+	struct wlr_box box = e->hit.box;
+	if (cursor->cursor->y < e->hit.thresh_top) {
 		edge = WLR_EDGE_TOP;
 		box.height = drop_layout_border;
-	} else if (cursor->cursor->y > thresh_bottom) {
+	} else if (cursor->cursor->y > e->hit.thresh_bottom) {
 		edge = WLR_EDGE_BOTTOM;
 		box.y = box.y + box.height - drop_layout_border;
 		box.height = drop_layout_border;
-	} else if (cursor->cursor->x < thresh_left) {
+	} else if (cursor->cursor->x < e->hit.thresh_left) {
 		edge = WLR_EDGE_LEFT;
 		box.width = drop_layout_border;
-	} else if (cursor->cursor->x > thresh_right) {
+	} else if (cursor->cursor->x > e->hit.thresh_right) {
 		edge = WLR_EDGE_RIGHT;
 		box.x = box.x + box.width - drop_layout_border;
 		box.width = drop_layout_border;
@@ -187,19 +257,33 @@ static void handle_motion_postthreshold(struct sway_seat *seat) {
 		box.x += drop_layout_border;
 		box.y += drop_layout_border;
 	}
-	e->target_node = &con->node;
-	e->target_edge = edge;
+	if (e->target_node == &e->hit.con->node && e->target_edge == edge &&
+			wlr_box_equal(&box, &e->indicator_box)) {
+		// Same drop zone in the same place, nothing to redo
+		return;
+	}
+	set_target(e, &e->hit.con->node, edge);
 	update_indicator(e, &box);
 	// Set focus on container so we can scroll the view
 	seat_set_focus(seat, node);
-	arrange_workspace(workspace);
+	arrange_workspace(e->hit.con->pending.workspace);
 	return;
 }
 
+static void handle_throttled_motion(void *data) {
+	struct sway_seat *seat = data;
+	handle_motion_postthreshold(seat);
+	transaction_commit_dirty();
+}
+
 static void handle_pointer_motion(struct sway_seat *seat, uint32_t time_msec) {
 	struct seatop_move_tiling_event *e = seat->seatop_data;
 	if (e->threshold_reached) {
-		handle_motion_postthreshold(seat);
+		// Handled now if no motion was handled during the last frame,
+		// otherwise when the frame is over
+		if (refresh_throttle_request(&e->motion)) {
+			handle_motion_postthreshold(seat);
+		}
 	} else {
 		handle_motion_prethreshold(seat);
 	}
@@ -209,6 +293,11 @@ static void handle_pointer_motion(struct sway_seat *seat, uint32_t time_msec) {
 static void finalize_move(struct sway_seat *seat) {
 	struct seatop_move_tiling_event *e = seat->seatop_data;
 
+	if (refresh_throttle_cancel(&e->motion)) {
+		// Drop where the pointer was released, not where it was last frame
+		handle_motion_postthreshold(seat);
+	}
+
 	if (!e->target_node) {
 		seatop_begin_default(seat);
 		return;
@@ -255,6 +344,10 @@ static void handle_unref(struct sway_seat *seat, struct sway_container *con) {
 	if (e->target_node == &con->node) { // Drop target
 		e->target_node = NULL;
 	}
+	if (e->hit.node == &con->node || e->hit.con == con) {
+		e->hit.node = NULL;
+		e->hit.con = NULL;
+	}
 	if (e->con == con) { // The container being moved
 		seatop_begin_default(seat);
 	}
@@ -297,6 +390,8 @@ void seatop_begin_move_tiling_threshold(struct sway_seat *seat,
 	e->con = con;
 	e->ref_lx = seat->cursor->cursor->x;
 	e->ref_ly = seat->cursor->cursor->y;
+	refresh_throttle_init(&e->motion, seat->cursor->cursor,
+		handle_throttled_motion, seat);
 
 	seat->seatop_impl = &seatop_impl;
 	seat->seatop_data = e;
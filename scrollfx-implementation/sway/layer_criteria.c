@@ -4,6 +4,10 @@
 #include "sway/config.h"
 #include "sway/layer_criteria.h"
 #include "sway/layers.h"
+#include "sway/mem_stats.h"
+#include "sway/output.h"
+#include "sway/scene_descriptor.h"
+#include "sway/tree/root.h"
 #include "list.h"
 
 /**
@@ -14,6 +18,7 @@ void layer_criteria_destroy(struct layer_criteria *criteria) {
 		return;
 	}
 
+	mem_account_free(MEM_LAYER_CRITERIA, sizeof(struct layer_criteria));
 	free(criteria->namespace);
 	free(criteria->cmdlist);
 	free(criteria);
@@ -29,6 +34,7 @@ struct layer_criteria *layer_criteria_add(char *namespace, char *cmdlist) {
 		sway_log(SWAY_ERROR, "Failed to allocate layer criteria");
 		return NULL;
 	}
+	mem_account_alloc(MEM_LAYER_CRITERIA, sizeof(struct layer_criteria));
 
 	criteria->namespace = strdup(namespace);
 	criteria->cmdlist = cmdlist ? strdup(cmdlist) : NULL;
@@ -63,14 +69,14 @@ struct layer_criteria *layer_criteria_add(char *namespace, char *cmdlist) {
 
 /**
  * Find layer criteria for a given namespace
- * Returns the matching criteria or NULL if not found
+ * Returns the last matching criteria added, or NULL if not found
  */
 struct layer_criteria *layer_criteria_for_namespace(char *namespace) {
 	if (!config->layer_criteria || !namespace) {
 		return NULL;
 	}
 
-	for (int i = 0; i < config->layer_criteria->length; ++i) {
+	for (int i = config->layer_criteria->length - 1; i >= 0; --i) {
 		struct layer_criteria *criteria = config->layer_criteria->items[i];
 		if (criteria && criteria->namespace &&
 				strcmp(criteria->namespace, namespace) == 0) {
@@ -105,3 +111,36 @@ void layer_apply_criteria(struct sway_layer_surface *surface,
 		surface->corner_radius = 0;
 	}
 }
+
+/**
+ * Apply the matching criteria to the layer surfaces of every output, or only
+ * to those with the given namespace
+ */
+void layer_criteria_apply(const char *namespace) {
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		struct wlr_scene_tree *layers[] = {
+			output->layers.shell_background,
+			output->layers.shell_bottom,
+			output->layers.shell_overlay,
+			output->layers.shell_top,
+		};
+		size_t nlayers = sizeof(layers) / sizeof(layers[0]);
+		for (size_t j = 0; j < nlayers; ++j) {
+			struct wlr_scene_node *node;
+			wl_list_for_each(node, &layers[j]->children, link) {
+				struct sway_layer_surface *surface = scene_descriptor_try_get(node,
+					SWAY_SCENE_DESC_LAYER_SHELL);
+				if (!surface || !surface->layer_surface->namespace ||
+						(namespace && strcmp(surface->layer_surface->namespace,
+							namespace) != 0)) {
+					continue;
+				}
+				layer_apply_criteria(surface, layer_criteria_for_namespace(
+					surface->layer_surface->namespace));
+			}
+		}
+
+		arrange_layers(output);
+	}
+}
@@ -0,0 +1,109 @@
+#include <json.h>
+#include <inttypes.h>
+#include <pixman.h>
+#include <signal.h>
+#include "log.h"
+#include "sway/mem_stats.h"
+#include "sway/tree/root.h"
+#include "sway/tree/scene.h"
+
+struct mem_tag_stats mem_stats[MEM_TAG_COUNT] = {0};
+
+static const char *mem_tag_names[MEM_TAG_COUNT] = {
+	[MEM_CONTAINER] = "containers",
+	[MEM_SCENE_NODE] = "scene_nodes",
+	[MEM_REGION] = "regions",
+	[MEM_TEXT] = "text_buffers",
+	[MEM_SAVED_BUFFER] = "saved_buffers",
+	[MEM_TRANSACTION] = "transactions",
+	[MEM_LAYER_CRITERIA] = "layer_criteria",
+	[MEM_TEXTURE] = "textures",
+};
+
+static size_t region_bytes(const pixman_region32_t *region) {
+	// Empty and single-box regions use pixman's static data
+	if (!region->data || region->data->size == 0) {
+		return 0;
+	}
+	return sizeof(*region->data) + region->data->size * sizeof(pixman_box32_t);
+}
+
+static void sample_regions(struct sway_scene_node *node, struct mem_tag_stats *stats) {
+	size_t bytes = region_bytes(&node->visible);
+	if (node->type == SWAY_SCENE_NODE_BUFFER) {
+		struct sway_scene_buffer *buffer = sway_scene_buffer_from_node(node);
+		bytes += region_bytes(&buffer->opaque_region);
+	}
+	if (bytes > 0) {
+		stats->bytes += bytes;
+		stats->count++;
+	}
+
+	if (node->type == SWAY_SCENE_NODE_TREE) {
+		struct sway_scene_tree *tree = sway_scene_tree_from_node(node);
+		struct sway_scene_node *child;
+		wl_list_for_each(child, &tree->children, link) {
+			sample_regions(child, stats);
+		}
+	}
+}
+
+// Regions grow and shrink inside pixman, so they are measured by walking the
+// scene instead of being tracked as they change
+static void mem_stats_sample(void) {
+	struct mem_tag_stats *stats = &mem_stats[MEM_REGION];
+	stats->bytes = 0;
+	stats->count = 0;
+	if (root && root->root_scene) {
+		sample_regions(&root->root_scene->tree.node, stats);
+	}
+	if (stats->bytes > stats->peak_bytes) {
+		stats->peak_bytes = stats->bytes;
+	}
+}
+
+json_object *mem_stats_get_json(void) {
+	mem_stats_sample();
+
+	json_object *object = json_object_new_object();
+	int64_t total = 0, total_peak = 0;
+	for (int i = 0; i < MEM_TAG_COUNT; ++i) {
+		json_object *tag = json_object_new_object();
+		json_object_object_add(tag, "bytes",
+			json_object_new_int64(mem_stats[i].bytes));
+		json_object_object_add(tag, "peak_bytes",
+			json_object_new_int64(mem_stats[i].peak_bytes));
+		json_object_object_add(tag, "count",
+			json_object_new_int64(mem_stats[i].count));
+		json_object_object_add(object, mem_tag_names[i], tag);
+		total += mem_stats[i].bytes;
+		total_peak += mem_stats[i].peak_bytes;
+	}
+	// The sum of the peaks bounds the peak of the sum from above
+	json_object_object_add(object, "total_bytes", json_object_new_int64(total));
+	json_object_object_add(object, "total_peak_bytes",
+		json_object_new_int64(total_peak));
+	return object;
+}
+
+void mem_stats_dump(void) {
+	mem_stats_sample();
+
+	sway_log(SWAY_INFO, "Memory by subsystem (bytes, peak bytes, objects):");
+	for (int i = 0; i < MEM_TAG_COUNT; ++i) {
+		sway_log(SWAY_INFO, "  %-15s %12" PRId64 " %12" PRId64 " %8" PRId64,
+			mem_tag_names[i], mem_stats[i].bytes, mem_stats[i].peak_bytes,
+			mem_stats[i].count);
+	}
+}
+
+static int handle_sigusr1(int signal, void *data) {
+	mem_stats_dump();
+	return 0;
+}
+
+void mem_stats_init(struct wl_event_loop *loop) {
+	if (!wl_event_loop_add_signal(loop, SIGUSR1, handle_sigusr1, NULL)) {
+		sway_log(SWAY_ERROR, "Unable to handle SIGUSR1 for memory stats");
+	}
+}
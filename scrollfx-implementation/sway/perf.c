@@ -0,0 +1,298 @@
+#include <inttypes.h>
+#include <json.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "list.h"
+#include "log.h"
+#include "sway/mem_stats.h"
+#include "sway/output.h"
+#include "sway/perf.h"
+#include "sway/scene_descriptor.h"
+#include "sway/tree/root.h"
+#include "sway/tree/view.h"
+
+struct perf_stats perf_stats = {0};
+
+// Configure-ack latency of one client, keyed by app_id (or X11 class)
+struct perf_client_stats {
+	char *name;
+	struct perf_histogram configure_latency;
+	uint64_t timeouts;
+};
+
+static list_t *perf_clients = NULL; // struct perf_client_stats
+
+const int perf_txn_wait_bounds[PERF_TXN_WAIT_BUCKETS - 1] = {
+	1, 2, 4, 8, 16, 33, 66,
+};
+
+void perf_record_txn_wait(double ms) {
+	perf_stats.last_txn_wait_ms = ms;
+
+	int i = 0;
+	while (i < PERF_TXN_WAIT_BUCKETS - 1 && ms > perf_txn_wait_bounds[i]) {
+		++i;
+	}
+	perf_stats.txn_wait[i]++;
+
+	perf_histogram_add(&perf_stats.txn_latency, ms * 1000);
+}
+
+static int histogram_bucket(int64_t us) {
+	const int sub_count = 1 << PERF_HIST_SUB_BITS;
+	if (us < sub_count) {
+		return us < 0 ? 0 : us;
+	}
+	int msb = 63 - __builtin_clzll(us);
+	int shift = msb - PERF_HIST_SUB_BITS;
+	int bucket = (shift + 1) * sub_count + ((us >> shift) & (sub_count - 1));
+	return bucket < PERF_HIST_BUCKETS ? bucket : PERF_HIST_BUCKETS - 1;
+}
+
+static int64_t histogram_bucket_max(int bucket) {
+	const int sub_count = 1 << PERF_HIST_SUB_BITS;
+	if (bucket < sub_count) {
+		return bucket;
+	}
+	int shift = bucket / sub_count - 1;
+	int64_t sub = sub_count + bucket % sub_count;
+	return ((sub + 1) << shift) - 1;
+}
+
+void perf_histogram_add(struct perf_histogram *hist, int64_t us) {
+	hist->counts[histogram_bucket(us)]++;
+	hist->total++;
+	if (us > hist->max_us) {
+		hist->max_us = us;
+	}
+}
+
+int64_t perf_histogram_percentile(const struct perf_histogram *hist,
+		double percentile) {
+	if (hist->total == 0) {
+		return 0;
+	}
+	uint64_t rank = hist->total * percentile / 100.0;
+	if (rank < 1) {
+		rank = 1;
+	}
+	uint64_t seen = 0;
+	for (int i = 0; i < PERF_HIST_BUCKETS; ++i) {
+		seen += hist->counts[i];
+		if (seen >= rank) {
+			int64_t max = histogram_bucket_max(i);
+			return max < hist->max_us ? max : hist->max_us;
+		}
+	}
+	return hist->max_us;
+}
+
+static const char *view_get_client_name(struct sway_view *view) {
+	const char *name = view_get_app_id(view);
+	if (!name) {
+		name = view_get_class(view);
+	}
+	return name ? name : "unknown";
+}
+
+void perf_node_get_source_name(struct sway_scene_node *node,
+		char *name, size_t size) {
+	const char *kind = node->type == SWAY_SCENE_NODE_RECT ? "rect" :
+		node->type == SWAY_SCENE_NODE_BUFFER ? "buffer" : "tree";
+
+	for (struct sway_scene_node *it = node; it; it = it->parent ? &it->parent->node : NULL) {
+		struct sway_view *view = scene_descriptor_try_get(it, SWAY_SCENE_DESC_VIEW);
+		if (view) {
+			snprintf(name, size, "view:%s", view_get_client_name(view));
+			return;
+		}
+		if (scene_descriptor_try_get(it, SWAY_SCENE_DESC_LAYER_SHELL)) {
+			snprintf(name, size, "layer_shell");
+			return;
+		}
+		if (scene_descriptor_try_get(it, SWAY_SCENE_DESC_CONTAINER)) {
+			// Borders, title bars and their text
+			snprintf(name, size, "decoration:%s", kind);
+			return;
+		}
+	}
+	snprintf(name, size, "other:%s", kind);
+}
+
+static struct perf_client_stats *perf_client_get(struct sway_view *view) {
+	const char *name = view_get_client_name(view);
+	if (!perf_clients) {
+		perf_clients = create_list();
+	}
+	for (int i = 0; i < perf_clients->length; ++i) {
+		struct perf_client_stats *client = perf_clients->items[i];
+		if (strcmp(client->name, name) == 0) {
+			return client;
+		}
+	}
+
+	struct perf_client_stats *client = calloc(1, sizeof(*client));
+	if (!client) {
+		sway_log(SWAY_ERROR, "Unable to allocate client latency stats");
+		return NULL;
+	}
+	client->name = strdup(name);
+	list_add(perf_clients, client);
+	return client;
+}
+
+void perf_record_configure_ack(struct sway_view *view, int64_t us) {
+	struct perf_client_stats *client = perf_client_get(view);
+	if (client) {
+		perf_histogram_add(&client->configure_latency, us);
+	}
+}
+
+void perf_record_configure_timeout(struct sway_view *view) {
+	struct perf_client_stats *client = perf_client_get(view);
+	if (client) {
+		client->timeouts++;
+	}
+}
+
+static json_object *histogram_get_json(const struct perf_histogram *hist) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "count",
+		json_object_new_int64(hist->total));
+	json_object_object_add(object, "p50_us",
+		json_object_new_int64(perf_histogram_percentile(hist, 50)));
+	json_object_object_add(object, "p90_us",
+		json_object_new_int64(perf_histogram_percentile(hist, 90)));
+	json_object_object_add(object, "p99_us",
+		json_object_new_int64(perf_histogram_percentile(hist, 99)));
+	json_object_object_add(object, "max_us",
+		json_object_new_int64(hist->max_us));
+	return object;
+}
+
+// Like histogram_get_json(), with the non-empty buckets keyed by their upper
+// bound in us, so that two snapshots can be subtracted
+static json_object *histogram_get_json_with_buckets(
+		const struct perf_histogram *hist) {
+	json_object *object = histogram_get_json(hist);
+	json_object *buckets = json_object_new_object();
+	for (int i = 0; i < PERF_HIST_BUCKETS; ++i) {
+		if (hist->counts[i] == 0) {
+			continue;
+		}
+		char key[24];
+		snprintf(key, sizeof(key), "%" PRId64, histogram_bucket_max(i));
+		json_object_object_add(buckets, key,
+			json_object_new_int64(hist->counts[i]));
+	}
+	json_object_object_add(object, "buckets", buckets);
+	return object;
+}
+
+static json_object *perf_output_get_json(struct sway_output *output) {
+	struct sway_scene_output *scene_output = output->scene_output;
+	json_object *object = json_object_new_object();
+
+	json_object_object_add(object, "name",
+		json_object_new_string(output->wlr_output->name));
+	json_object_object_add(object, "frames_rendered",
+		json_object_new_int64(scene_output->stats.frames));
+	json_object_object_add(object, "frames_skipped",
+		json_object_new_int64(output->perf.frames_skipped));
+	json_object_object_add(object, "direct_scanouts",
+		json_object_new_int64(scene_output->stats.direct_scanouts));
+	json_object_object_add(object, "missed_deadlines",
+		json_object_new_int64(output->perf.missed_deadlines));
+	json_object_object_add(object, "render_list_length",
+		json_object_new_int(scene_output->stats.render_list_len));
+	json_object_object_add(object, "damaged_area",
+		json_object_new_int64(scene_output->stats.damaged_area));
+	json_object_object_add(object, "pre_render_ns",
+		json_object_new_int64(output->perf.pre_render_ns));
+	json_object_object_add(object, "render_ns",
+		json_object_new_int64(output->perf.render_ns));
+	json_object_object_add(object, "pre_render_us",
+		histogram_get_json_with_buckets(&output->perf.pre_render_hist));
+	json_object_object_add(object, "render_us",
+		histogram_get_json_with_buckets(&output->perf.render_hist));
+
+	return object;
+}
+
+json_object *perf_stats_get_json(void) {
+	json_object *object = json_object_new_object();
+
+	json_object *outputs = json_object_new_array();
+	for (int i = 0; i < root->outputs->length; ++i) {
+		struct sway_output *output = root->outputs->items[i];
+		json_object_array_add(outputs, perf_output_get_json(output));
+	}
+	json_object_object_add(object, "outputs", outputs);
+
+	// Counted by the memory accounting
+	json_object_object_add(object, "scene_nodes",
+		json_object_new_int64(mem_stats[MEM_SCENE_NODE].count));
+	json_object_object_add(object, "textures",
+		json_object_new_int64(mem_stats[MEM_TEXTURE].count));
+	json_object_object_add(object, "texture_bytes",
+		json_object_new_int64(mem_stats[MEM_TEXTURE].bytes));
+	json_object_object_add(object, "saved_buffers",
+		json_object_new_int64(mem_stats[MEM_SAVED_BUFFER].count));
+
+	// Buckets are keyed by their upper bound in ms
+	json_object *txn_wait = json_object_new_object();
+	for (int i = 0; i < PERF_TXN_WAIT_BUCKETS; ++i) {
+		char key[16];
+		if (i < PERF_TXN_WAIT_BUCKETS - 1) {
+			snprintf(key, sizeof(key), "%d", perf_txn_wait_bounds[i]);
+		} else {
+			snprintf(key, sizeof(key), "inf");
+		}
+		json_object_object_add(txn_wait, key,
+			json_object_new_int64(perf_stats.txn_wait[i]));
+	}
+	json_object_object_add(object, "transaction_wait_ms", txn_wait);
+	json_object_object_add(object, "transaction_latency",
+		histogram_get_json(&perf_stats.txn_latency));
+	json_object_object_add(object, "transaction_timeouts",
+		json_object_new_int64(perf_stats.txn_timeouts));
+
+	return object;
+}
+
+// Clients that made transactions time out come first, then the slowest
+static int cmp_clients_desc(const void *a, const void *b) {
+	const struct perf_client_stats *ca = *(void **)a, *cb = *(void **)b;
+	if (ca->timeouts != cb->timeouts) {
+		return ca->timeouts < cb->timeouts ? 1 : -1;
+	}
+	int64_t pa = perf_histogram_percentile(&ca->configure_latency, 99);
+	int64_t pb = perf_histogram_percentile(&cb->configure_latency, 99);
+	return pa < pb ? 1 : pa > pb ? -1 : 0;
+}
+
+json_object *perf_txn_blame_get_json(int limit) {
+	json_object *object = json_object_new_object();
+	json_object_object_add(object, "transaction_latency",
+		histogram_get_json(&perf_stats.txn_latency));
+	json_object_object_add(object, "transaction_timeouts",
+		json_object_new_int64(perf_stats.txn_timeouts));
+
+	json_object *clients = json_object_new_array();
+	if (perf_clients) {
+		list_qsort(perf_clients, cmp_clients_desc);
+		for (int i = 0; i < perf_clients->length && i < limit; ++i) {
+			struct perf_client_stats *client = perf_clients->items[i];
+			json_object *entry = histogram_get_json(&client->configure_latency);
+			json_object_object_add(entry, "app_id",
+				json_object_new_string(client->name));
+			json_object_object_add(entry, "timeouts",
+				json_object_new_int64(client->timeouts));
+			json_object_array_add(clients, entry);
+		}
+	}
+	json_object_object_add(object, "clients", clients);
+
+	return object;
+}
@@ -0,0 +1,223 @@
+#include <pixman.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <wlr/config.h>
+#include <wlr/types/wlr_compositor.h>
+#include "log.h"
+#include "sway/replay.h"
+#include "sway/tree/container.h"
+#include "sway/tree/view.h"
+
+static FILE *replay_file = NULL;
+static struct timespec replay_last_event;
+
+static uint32_t replay_delta_usec(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	int64_t delta = (int64_t)(now.tv_sec - replay_last_event.tv_sec) * 1000000 +
+		(now.tv_nsec - replay_last_event.tv_nsec) / 1000;
+	replay_last_event = now;
+	return delta > UINT32_MAX ? UINT32_MAX : delta;
+}
+
+static void replay_write_event(enum replay_event_type type,
+		const void *payload, size_t payload_len,
+		const void *extra, size_t extra_len) {
+	// The length field is 16 bits wide; trim the variable part first
+	if (payload_len > UINT16_MAX) {
+		payload_len = UINT16_MAX;
+	}
+	if (extra_len > UINT16_MAX - payload_len) {
+		extra_len = UINT16_MAX - payload_len;
+	}
+	struct replay_event_header header = {
+		.type = type,
+		.length = payload_len + extra_len,
+		.delta_us = replay_delta_usec(),
+	};
+	fwrite(&header, sizeof(header), 1, replay_file);
+	fwrite(payload, payload_len, 1, replay_file);
+	if (extra_len > 0) {
+		fwrite(extra, extra_len, 1, replay_file);
+	}
+	if (ferror(replay_file)) {
+		sway_log(SWAY_ERROR, "Unable to write replay log, stopping");
+		replay_record_stop();
+	}
+}
+
+bool replay_record_start(const char *path) {
+	replay_record_stop();
+
+	replay_file = fopen(path, "wb");
+	if (!replay_file) {
+		sway_log_errno(SWAY_ERROR, "Unable to open replay log %s", path);
+		return false;
+	}
+
+	fwrite(REPLAY_MAGIC, REPLAY_MAGIC_LEN, 1, replay_file);
+	clock_gettime(CLOCK_MONOTONIC, &replay_last_event);
+	sway_log(SWAY_INFO, "Recording frame loop to %s", path);
+	return true;
+}
+
+void replay_record_stop(void) {
+	if (!replay_file) {
+		return;
+	}
+
+	fclose(replay_file);
+	replay_file = NULL;
+}
+
+bool replay_recording(void) {
+	return replay_file != NULL;
+}
+
+static uint32_t view_get_replay_id(struct sway_view *view) {
+	return view->container ? view->container->node.id : 0;
+}
+
+static void replay_record_view_event(enum replay_event_type type,
+		struct sway_view *view, int width, int height,
+		const char *extra) {
+	struct replay_view payload = {
+		.view_id = view_get_replay_id(view),
+		.width = width,
+		.height = height,
+	};
+#if WLR_HAS_XWAYLAND
+	payload.xwayland = view->type == SWAY_VIEW_XWAYLAND;
+#endif
+	replay_write_event(type, &payload, sizeof(payload),
+		extra, extra ? strlen(extra) : 0);
+}
+
+void replay_record_view_map(struct sway_view *view) {
+	if (!replay_file) {
+		return;
+	}
+	const char *app_id = view_get_app_id(view);
+	if (!app_id) {
+		app_id = view_get_class(view);
+	}
+	replay_record_view_event(REPLAY_VIEW_MAP, view,
+		view->geometry.width, view->geometry.height, app_id);
+}
+
+void replay_record_view_unmap(struct sway_view *view) {
+	if (replay_file) {
+		replay_record_view_event(REPLAY_VIEW_UNMAP, view, 0, 0, NULL);
+	}
+}
+
+void replay_record_configure(struct sway_view *view, int width, int height) {
+	if (replay_file) {
+		replay_record_view_event(REPLAY_CONFIGURE, view, width, height, NULL);
+	}
+}
+
+void replay_record_configure_ack(struct sway_view *view) {
+	if (replay_file) {
+		replay_record_view_event(REPLAY_CONFIGURE_ACK, view,
+			view->geometry.width, view->geometry.height, NULL);
+	}
+}
+
+// Copies up to REPLAY_MAX_RECTS rectangles of region, or its extents
+static int region_to_rects(const pixman_region32_t *region,
+		struct replay_rect *rects) {
+	int nrects;
+	const pixman_box32_t *boxes = pixman_region32_rectangles(
+		(pixman_region32_t *)region, &nrects);
+	if (nrects > REPLAY_MAX_RECTS) {
+		boxes = pixman_region32_extents((pixman_region32_t *)region);
+		nrects = 1;
+	}
+	for (int i = 0; i < nrects; ++i) {
+		rects[i] = (struct replay_rect){
+			.x = boxes[i].x1,
+			.y = boxes[i].y1,
+			.width = boxes[i].x2 - boxes[i].x1,
+			.height = boxes[i].y2 - boxes[i].y1,
+		};
+	}
+	return nrects;
+}
+
+void replay_record_commit(struct sway_view *view, struct wlr_surface *surface) {
+	if (!replay_file) {
+		return;
+	}
+
+	struct replay_rect rects[2 * REPLAY_MAX_RECTS];
+	struct replay_commit payload = {
+		.view_id = view_get_replay_id(view),
+		.width = surface->current.width,
+		.height = surface->current.height,
+	};
+	payload.damage_rects = region_to_rects(&surface->buffer_damage, rects);
+	payload.opaque_rects = region_to_rects(&surface->opaque_region,
+		rects + payload.damage_rects);
+
+	replay_write_event(REPLAY_COMMIT, &payload, sizeof(payload), rects,
+		(payload.damage_rects + payload.opaque_rects) * sizeof(*rects));
+}
+
+void replay_record_command(const char *command) {
+	if (replay_file) {
+		replay_write_event(REPLAY_COMMAND, command, strlen(command), NULL, 0);
+	}
+}
+
+void replay_record_pointer_motion(uint32_t time_msec, double dx, double dy) {
+	if (!replay_file) {
+		return;
+	}
+	struct replay_pointer_motion payload = {
+		.time_msec = time_msec,
+		.dx = dx,
+		.dy = dy,
+	};
+	replay_write_event(REPLAY_POINTER_MOTION, &payload, sizeof(payload), NULL, 0);
+}
+
+void replay_record_pointer_button(uint32_t time_msec, uint32_t button,
+		uint32_t state) {
+	if (!replay_file) {
+		return;
+	}
+	struct replay_input payload = {
+		.time_msec = time_msec,
+		.code = button,
+		.state = state,
+	};
+	replay_write_event(REPLAY_POINTER_BUTTON, &payload, sizeof(payload), NULL, 0);
+}
+
+void replay_record_pointer_axis(uint32_t time_msec, uint32_t orientation,
+		double delta, int32_t delta_discrete) {
+	if (!replay_file) {
+		return;
+	}
+	struct replay_pointer_axis payload = {
+		.time_msec = time_msec,
+		.orientation = orientation,
+		.delta = delta,
+		.delta_discrete = delta_discrete,
+	};
+	replay_write_event(REPLAY_POINTER_AXIS, &payload, sizeof(payload), NULL, 0);
+}
+
+void replay_record_key(uint32_t time_msec, uint32_t keycode, uint32_t state) {
+	if (!replay_file) {
+		return;
+	}
+	struct replay_input payload = {
+		.time_msec = time_msec,
+		.code = keycode,
+		.state = state,
+	};
+	replay_write_event(REPLAY_KEY, &payload, sizeof(payload), NULL, 0);
+}
@@ -0,0 +1,99 @@
+#include <inttypes.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include "log.h"
+#include "sway/trace.h"
+
+static FILE *trace_file = NULL;
+static bool trace_first_event = true;
+
+static int64_t trace_timestamp_usec(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void trace_write_string(const char *str) {
+	fputc('"', trace_file);
+	for (const char *c = str; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', trace_file);
+			fputc(*c, trace_file);
+		} else if ((unsigned char)*c < 0x20) {
+			fprintf(trace_file, "\\u%04x", *c);
+		} else {
+			fputc(*c, trace_file);
+		}
+	}
+	fputc('"', trace_file);
+}
+
+static void trace_write_event(char phase, const char *name, const char *detail) {
+	fprintf(trace_file, "%s{\"ph\":\"%c\",\"ts\":%" PRId64 ",\"pid\":%d,\"tid\":%d",
+		trace_first_event ? "" : ",\n", phase, trace_timestamp_usec(),
+		getpid(), getpid());
+	trace_first_event = false;
+
+	if (name) {
+		fputs(",\"name\":", trace_file);
+		trace_write_string(name);
+	}
+	if (phase == 'i') {
+		// Instant events are scoped to the thread so they line up with spans
+		fputs(",\"s\":\"t\"", trace_file);
+	}
+	if (detail) {
+		fputs(",\"args\":{\"detail\":", trace_file);
+		trace_write_string(detail);
+		fputc('}', trace_file);
+	}
+	fputc('}', trace_file);
+}
+
+bool trace_start(const char *path) {
+	trace_stop();
+
+	trace_file = fopen(path, "w");
+	if (!trace_file) {
+		sway_log_errno(SWAY_ERROR, "Unable to open trace file %s", path);
+		return false;
+	}
+
+	trace_first_event = true;
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", trace_file);
+	sway_log(SWAY_INFO, "Writing trace to %s", path);
+	return true;
+}
+
+void trace_stop(void) {
+	if (!trace_file) {
+		return;
+	}
+
+	fputs("\n]}\n", trace_file);
+	fclose(trace_file);
+	trace_file = NULL;
+}
+
+bool trace_enabled(void) {
+	return trace_file != NULL;
+}
+
+void trace_begin(const char *name, const char *detail) {
+	if (trace_file) {
+		trace_write_event('B', name, detail);
+	}
+}
+
+void trace_end(void) {
+	if (trace_file) {
+		trace_write_event('E', NULL, NULL);
+	}
+}
+
+void trace_instant(const char *name, const char *detail) {
+	if (trace_file) {
+		trace_write_event('i', name, detail);
+	}
+}
@@ -8,15 +8,18 @@
 #include <wlr/types/wlr_output_layout.h>
 #include <wlr/types/wlr_subcompositor.h>
 #include "sway/config.h"
+#include "sway/criteria_index.h"
 #include "sway/desktop/transaction.h"
 #include "sway/input/input-manager.h"
 #include "sway/input/seat.h"
 #include "sway/ipc-server.h"
 #include "sway/scene_descriptor.h"
 #include "sway/sway_text_node.h"
+#include "sway/mem_stats.h"
 #include "sway/output.h"
 #include "sway/server.h"
 #include "sway/tree/arrange.h"
+#include "sway/tree/root.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "sway/xdg_decoration.h"
@@ -88,7 +91,9 @@ struct sway_container *container_create(struct sway_view *view) {
 		sway_log(SWAY_ERROR, "Unable to allocate sway_container");
 		return NULL;
 	}
+	mem_account_alloc(MEM_CONTAINER, sizeof(struct sway_container));
 	node_init(&c->node, N_CONTAINER, c);
+	root_index_add_container(c);
 
 	// Container tree structure
 	// - scene tree
@@ -375,7 +380,8 @@ void container_update(struct sway_container *con) {
 			color = config->dim_inactive_colors.urgent;
 		}
 		bool focused = con->current.focused || container_is_current_parent_focused(con);
-		scene_rect_set_color(con->dim_rect, color, focused ? 0.0 : con->dim);
+		bool culled = container_effects_culled(con);
+		scene_rect_set_color(con->dim_rect, color, focused || culled ? 0.0 : con->dim);
 	}
 }
 
@@ -419,10 +425,19 @@ void container_arrange_title_bar(struct sway_container *con) {
 	pixman_region64f_t text_area;
 	pixman_region64f_init(&text_area);
 
-	struct sway_workspace *workspace = con->pending.workspace;
+	struct sway_workspace *workspace = con->current.workspace;
 	double scale = workspace ? (layout_scale_enabled(workspace) ? layout_scale_get(workspace) : 1.0) : 1.0;
 
+	// Text is unreadable when scaled this far down, draw only flat rects
+	bool flat = container_effects_culled(con);
 	if (con->title_bar.marks_text) {
+		sway_scene_node_set_enabled(con->title_bar.marks_text->node, !flat);
+	}
+	if (con->title_bar.title_text) {
+		sway_scene_node_set_enabled(con->title_bar.title_text->node, !flat);
+	}
+
+	if (con->title_bar.marks_text && !flat) {
 		struct sway_text_node *node = con->title_bar.marks_text;
 		marks_buffer_width = node->width;
 
@@ -448,7 +463,7 @@ void container_arrange_title_bar(struct sway_container *con) {
 			node->node->x, node->node->y, round(scale * alloc_width), scale * node->height);
 	}
 
-	if (con->title_bar.title_text) {
+	if (con->title_bar.title_text && !flat) {
 		struct sway_text_node *node = con->title_bar.title_text;
 
 		double h_padding;
@@ -590,7 +605,11 @@ void container_destroy(struct sway_container *con) {
 	list_free(con->pending.children);
 	list_free(con->current.children);
 
+	for (int i = 0; i < con->marks->length; ++i) {
+		criteria_index_remove_mark(con, con->marks->items[i]);
+	}
 	list_free_items_and_destroy(con->marks);
+	root_index_remove_container(con);
 
 	if (con->view && con->view->container == con) {
 		con->view->container = NULL;
@@ -602,6 +621,7 @@ void container_destroy(struct sway_container *con) {
 
 	scene_node_disown_children(con->content_tree);
 	sway_scene_node_destroy(&con->scene_tree->node);
+	mem_account_free(MEM_CONTAINER, sizeof(struct sway_container));
 	free(con);
 }
 
@@ -1626,6 +1646,7 @@ void container_insert_child(struct sway_container *parent,
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
 	container_for_each_child(child, set_workspace, NULL);
+	root_tree_changed();
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
 }
@@ -1641,6 +1662,7 @@ void container_add_sibling(struct sway_container *fixed,
 	active->pending.parent = fixed->pending.parent;
 	active->pending.workspace = fixed->pending.workspace;
 	container_for_each_child(active, set_workspace, NULL);
+	root_tree_changed();
 	container_handle_fullscreen_reparent(active);
 	container_update_representation(active);
 }
@@ -1654,6 +1676,7 @@ void container_add_child(struct sway_container *parent,
 	child->pending.parent = parent;
 	child->pending.workspace = parent->pending.workspace;
 	container_for_each_child(child, set_workspace, NULL);
+	root_tree_changed();
 	container_handle_fullscreen_reparent(child);
 	container_update_representation(parent);
 	node_set_dirty(&child->node);
@@ -1680,6 +1703,7 @@ void container_detach(struct sway_container *child) {
 	child->pending.parent = NULL;
 	child->pending.workspace = NULL;
 	container_for_each_child(child, set_workspace, NULL);
+	root_tree_changed();
 
 	if (old_parent) {
 		container_update_representation(old_parent);
@@ -1794,18 +1818,12 @@ bool container_is_transient_for(struct sway_container *child,
 		view_is_transient_for(child->view, ancestor->view);
 }
 
-static bool find_by_mark_iterator(struct sway_container *con, void *data) {
-	char *mark = data;
-	return container_has_mark(con, mark);
-}
-
 struct sway_container *container_find_mark(char *mark) {
-	return root_find_container(find_by_mark_iterator, mark);
+	return criteria_index_find_mark(mark);
 }
 
 bool container_find_and_unmark(char *mark) {
-	struct sway_container *con = root_find_container(
-		find_by_mark_iterator, mark);
+	struct sway_container *con = criteria_index_find_mark(mark);
 	if (!con) {
 		return false;
 	}
@@ -1813,6 +1831,7 @@ bool container_find_and_unmark(char *mark) {
 	for (int i = 0; i < con->marks->length; ++i) {
 		char *con_mark = con->marks->items[i];
 		if (strcmp(con_mark, mark) == 0) {
+			criteria_index_remove_mark(con, con_mark);
 			free(con_mark);
 			list_del(con->marks, i);
 			container_update_marks(con);
@@ -1825,6 +1844,7 @@ bool container_find_and_unmark(char *mark) {
 
 void container_clear_marks(struct sway_container *con) {
 	for (int i = 0; i < con->marks->length; ++i) {
+		criteria_index_remove_mark(con, con->marks->items[i]);
 		free(con->marks->items[i]);
 	}
 	con->marks->length = 0;
@@ -1843,6 +1863,7 @@ bool container_has_mark(struct sway_container *con, char *mark) {
 
 void container_add_mark(struct sway_container *con, char *mark) {
 	list_add(con->marks, strdup(mark));
+	criteria_index_add_mark(con, mark);
 	ipc_event_window(con, "mark");
 }
 
@@ -2111,3 +2132,17 @@ bool container_has_corner_radius(struct sway_container *con) {
 		!(config->smart_corner_radius && con->current.workspace->current_gaps.top == 0))
 		&& con->corner_radius;
 }
+
+bool container_effects_culled(struct sway_container *con) {
+	struct sway_workspace *ws = con->current.workspace;
+	if (config->effects_min_scale <= 0 || !ws || !layout_scale_enabled(ws)) {
+		return false;
+	}
+	return layout_scale_get(ws) < config->effects_min_scale;
+}
+
+int container_get_scaled_corner_radius(struct sway_container *con) {
+	struct sway_workspace *ws = con->current.workspace;
+	double scale = ws && layout_scale_enabled(ws) ? layout_scale_get(ws) : 1.0;
+	return round(con->corner_radius * scale);
+}
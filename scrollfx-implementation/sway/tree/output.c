@@ -111,6 +111,11 @@ struct sway_output *output_create(struct wlr_output *wlr_output) {
 	bool failed = false;
 	output->layers.shell_background = alloc_scene_tree(root->staging, &failed);
 	output->layers.shell_bottom = alloc_scene_tree(root->staging, &failed);
+	if (!failed) {
+		// Damage to these layers invalidates the cached blurred background
+		output->layers.shell_background->node.info.blur_source = true;
+		output->layers.shell_bottom->node.info.blur_source = true;
+	}
 
 	// Create optimized blur layer between shell_bottom and tiling
 	output->layers.blur_layer = wlr_scene_optimized_blur_create(root->staging, 0, 0);
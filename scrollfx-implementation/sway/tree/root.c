@@ -77,6 +77,7 @@ struct sway_root *root_create(struct wl_display *wl_display) {
 	root->scratchpad = create_list();
 
 	root->overview = false;
+	root->tree_serial = 1;
 
 	root->spaces = create_list();
 
@@ -334,6 +335,126 @@ struct sway_container *root_find_container(
 	return NULL;
 }
 
+struct root_index_entry {
+	size_t key;
+	struct sway_container *con;
+	struct root_index_entry *next;
+};
+
+// Hash map from ids or PIDs to containers. A PID can have several.
+struct root_index {
+	struct root_index_entry **buckets;
+	size_t nbuckets; // power of two
+	size_t count;
+};
+
+static struct root_index container_ids = {0};
+static struct root_index view_pids = {0};
+
+static bool root_index_resize(struct root_index *index, size_t nbuckets) {
+	struct root_index_entry **buckets = calloc(nbuckets, sizeof(*buckets));
+	if (!buckets) {
+		return false;
+	}
+	for (size_t i = 0; i < index->nbuckets; ++i) {
+		struct root_index_entry *entry = index->buckets[i];
+		while (entry) {
+			struct root_index_entry *next = entry->next;
+			struct root_index_entry **bucket =
+				&buckets[entry->key & (nbuckets - 1)];
+			entry->next = *bucket;
+			*bucket = entry;
+			entry = next;
+		}
+	}
+	free(index->buckets);
+	index->buckets = buckets;
+	index->nbuckets = nbuckets;
+	return true;
+}
+
+static void root_index_insert(struct root_index *index, size_t key,
+		struct sway_container *con) {
+	if (index->count >= index->nbuckets * 2) {
+		size_t nbuckets = index->nbuckets ? index->nbuckets * 2 : 64;
+		// A full table still works, only with longer chains
+		if (!root_index_resize(index, nbuckets) && !index->nbuckets) {
+			sway_log(SWAY_ERROR, "Unable to allocate tree index");
+			return;
+		}
+	}
+	struct root_index_entry *entry = calloc(1, sizeof(*entry));
+	if (!entry) {
+		sway_log(SWAY_ERROR, "Unable to allocate tree index entry");
+		return;
+	}
+	entry->key = key;
+	entry->con = con;
+	struct root_index_entry **bucket =
+		&index->buckets[key & (index->nbuckets - 1)];
+	entry->next = *bucket;
+	*bucket = entry;
+	index->count++;
+}
+
+static void root_index_erase(struct root_index *index, size_t key,
+		struct sway_container *con) {
+	if (!index->nbuckets) {
+		return;
+	}
+	struct root_index_entry **link =
+		&index->buckets[key & (index->nbuckets - 1)];
+	for (; *link; link = &(*link)->next) {
+		struct root_index_entry *entry = *link;
+		if (entry->key == key && entry->con == con) {
+			*link = entry->next;
+			free(entry);
+			index->count--;
+			return;
+		}
+	}
+}
+
+static struct sway_container *root_index_find(struct root_index *index,
+		size_t key) {
+	if (!index->nbuckets) {
+		return NULL;
+	}
+	struct root_index_entry *entry =
+		index->buckets[key & (index->nbuckets - 1)];
+	for (; entry; entry = entry->next) {
+		if (entry->key == key && !entry->con->node.destroying) {
+			return entry->con;
+		}
+	}
+	return NULL;
+}
+
+void root_index_add_container(struct sway_container *con) {
+	root_index_insert(&container_ids, con->node.id, con);
+}
+
+void root_index_remove_container(struct sway_container *con) {
+	root_index_erase(&container_ids, con->node.id, con);
+}
+
+void root_index_add_view(struct sway_view *view) {
+	root_index_insert(&view_pids, view->pid, view->container);
+}
+
+void root_index_remove_view(struct sway_view *view) {
+	root_index_erase(&view_pids, view->pid, view->container);
+}
+
+struct sway_container *root_find_container_by_id(size_t id) {
+	return root_index_find(&container_ids, id);
+}
+
+struct sway_view *root_find_view_by_pid(pid_t pid) {
+	struct sway_container *con = root_index_find(&view_pids, pid);
+	return con ? con->view : NULL;
+}
+
 void root_get_box(struct sway_root *root, struct wlr_box *box) {
 	box->x = root->x;
 	box->y = root->y;
@@ -341,6 +462,10 @@ void root_get_box(struct sway_root *root, struct wlr_box *box) {
 	box->height = root->height;
 }
 
+void root_tree_changed(void) {
+	root->tree_serial++;
+}
+
 static bool default_free_animation_activation_filter(struct sway_workspace *workspace,
 		void *data) {
 	return false;
@@ -19,7 +19,12 @@
 #include "sway/tree/workspace.h"
 #include "sway/scene_descriptor.h"
 #include "sway/tree/debug.h"
+#include "sway/desktop/damage_heatmap.h"
+#include "sway/desktop/render_profile.h"
+#include "sway/mem_stats.h"
 #include "sway/output.h"
+#include "sway/server.h"
+#include "sway/trace.h"
 
 #include <wlr/config.h>
 
@@ -84,6 +89,18 @@ struct sway_scene *scene_node_get_root(struct sway_scene_node *node) {
 	return scene;
 }
 
+static size_t scene_node_size(enum sway_scene_node_type type) {
+	switch (type) {
+	case SWAY_SCENE_NODE_TREE:
+		return sizeof(struct sway_scene_tree);
+	case SWAY_SCENE_NODE_RECT:
+		return sizeof(struct sway_scene_rect);
+	case SWAY_SCENE_NODE_BUFFER:
+		return sizeof(struct sway_scene_buffer);
+	}
+	return sizeof(struct sway_scene_node);
+}
+
 static void scene_node_init(struct sway_scene_node *node,
 		enum sway_scene_node_type type, struct sway_scene_tree *parent) {
 	*node = (struct sway_scene_node){
@@ -108,6 +125,7 @@ static void scene_node_init(struct sway_scene_node *node,
 	}
 
 	wlr_addon_set_init(&node->addons);
+	mem_account_alloc(MEM_SCENE_NODE, scene_node_size(type));
 }
 
 struct highlight_region {
@@ -131,6 +149,7 @@ void sway_scene_node_destroy(struct sway_scene_node *node) {
 	// are recursively destroyed.
 	wl_signal_emit_mutable(&node->events.destroy, NULL);
 	wlr_addon_set_finish(&node->addons);
+	mem_account_free(MEM_SCENE_NODE, scene_node_size(node->type));
 
 	sway_scene_node_set_enabled(node, false);
 
@@ -181,6 +200,13 @@ void sway_scene_node_destroy(struct sway_scene_node *node) {
 				&scene_tree->children, link) {
 			sway_scene_node_destroy(child);
 		}
+
+		if (scene_tree == &scene->tree) {
+			if (scene->xwayland_restack_idle) {
+				wl_event_source_remove(scene->xwayland_restack_idle);
+			}
+			wl_array_release(&scene->xwayland_stack);
+		}
 	}
 
 	assert(wl_list_empty(&node->events.destroy.listener_list));
@@ -209,6 +235,7 @@ struct sway_scene *sway_scene_create(void) {
 	wl_list_init(&scene->linux_dmabuf_v1_destroy.link);
 	wl_list_init(&scene->gamma_control_manager_v1_destroy.link);
 	wl_list_init(&scene->gamma_control_manager_v1_set_gamma.link);
+	wl_array_init(&scene->xwayland_stack);
 
 	const char *debug_damage_options[] = {
 		"none",
@@ -225,6 +252,10 @@ struct sway_scene *sway_scene_create(void) {
 	return scene;
 }
 
+void sway_scene_set_blur_kernel_size(struct sway_scene *scene, int size) {
+	scene->blur_kernel_size = size > 0 ? size : 0;
+}
+
 struct sway_scene_tree *sway_scene_tree_create(struct sway_scene_tree *parent) {
 	assert(parent);
 
@@ -326,7 +357,7 @@ struct scene_update_data {
 	bool calculate_visibility;
 
 #if WLR_HAS_XWAYLAND
-	struct wlr_xwayland_surface *restack_above;
+	bool restack_xwayland;
 #endif
 };
 
@@ -418,7 +449,39 @@ static void scene_output_damage_whole(struct sway_scene_output *scene_output) {
 	pixman_region32_fini(&damage);
 }
 
-static void scene_damage_outputs(struct sway_scene *scene, pixman_region32_t *damage) {
+static void scene_output_damage_blur(struct sway_scene_output *scene_output,
+		struct sway_scene_node *source, const pixman_region32_t *damage) {
+	struct wlr_output *output = scene_output->output;
+
+	// A changed pixel below the blur layer affects every blurred pixel within
+	// the kernel size, so both the cache and the frame need the expanded region
+	int expand = ceil(scene_output->scene->blur_kernel_size * output->scale);
+	pixman_region32_t expanded;
+	pixman_region32_init(&expanded);
+	wlr_region_expand(&expanded, damage, expand);
+	pixman_region32_intersect_rect(&expanded, &expanded, 0, 0, output->width, output->height);
+
+	if (!pixman_region32_empty(&expanded)) {
+		pixman_region32_union(&scene_output->blur_damage,
+			&scene_output->blur_damage, &expanded);
+		scene_output_damage(scene_output, &expanded);
+
+		if (damage_heatmap_recording()) {
+			pixman_region32_t blurred;
+			pixman_region32_init(&blurred);
+			pixman_region32_subtract(&blurred, &expanded,
+				(pixman_region32_t *)damage);
+			damage_heatmap_record_effect(source, "blur", &blurred,
+				1.0 / (output->scale * output->scale));
+			pixman_region32_fini(&blurred);
+		}
+	}
+
+	pixman_region32_fini(&expanded);
+}
+
+static void scene_damage_outputs(struct sway_scene *scene,
+		struct sway_scene_node *node, pixman_region32_t *damage, bool blur_source) {
 	if (pixman_region32_empty(damage)) {
 		return;
 	}
@@ -433,6 +496,9 @@ static void scene_damage_outputs(struct sway_scene *scene, pixman_region32_t *da
 		scale_region(&output_damage, scene_output->output->scale, true);
 		output_to_buffer_coords(&output_damage, scene_output->output);
 		scene_output_damage(scene_output, &output_damage);
+		if (blur_source) {
+			scene_output_damage_blur(scene_output, node, &output_damage);
+		}
 		pixman_region32_fini(&output_damage);
 	}
 }
@@ -570,33 +636,50 @@ static struct wlr_xwayland_surface *scene_node_try_get_managed_xwayland_surface(
 	return xwayland_surface;
 }
 
-static void restack_xwayland_surface(struct sway_scene_node *node,
-		struct wlr_box *box, struct scene_update_data *data) {
-	struct wlr_xwayland_surface *xwayland_surface =
-		scene_node_try_get_managed_xwayland_surface(node);
-	if (!xwayland_surface) {
-		return;
+struct xwayland_stack_entry {
+	// Only compared, the surface may be gone by the next restack
+	struct wlr_xwayland_surface *surface;
+	xcb_window_t window_id;
+};
+
+static int xwayland_stack_find(struct wl_array *stack,
+		struct xwayland_stack_entry *entry) {
+	struct xwayland_stack_entry *entries = stack->data;
+	size_t length = stack->size / sizeof(*entries);
+	for (size_t i = 0; i < length; i++) {
+		if (entries[i].surface == entry->surface &&
+				entries[i].window_id == entry->window_id) {
+			return i;
+		}
 	}
+	return -1;
+}
 
-	// ensure this node is entirely inside the update region. If not, we can't
-	// restack this node since we're not considering the whole thing.
-	if (wlr_box_contains_box(&data->update_box, box)) {
-		if (data->restack_above) {
-			wlr_xwayland_surface_restack(xwayland_surface, data->restack_above, XCB_STACK_MODE_BELOW);
-		} else {
-			wlr_xwayland_surface_restack(xwayland_surface, NULL, XCB_STACK_MODE_ABOVE);
+// Moves or inserts entry to position index of the stack
+static void xwayland_stack_move(struct wl_array *stack,
+		struct xwayland_stack_entry *entry, size_t index) {
+	int from = xwayland_stack_find(stack, entry);
+	if (from < 0) {
+		if (!wl_array_add(stack, sizeof(*entry))) {
+			return;
 		}
+		from = stack->size / sizeof(*entry) - 1;
 	}
 
-	data->restack_above = xwayland_surface;
+	struct xwayland_stack_entry *entries = stack->data;
+	memmove(&entries[index + 1], &entries[index],
+		(from - index) * sizeof(*entries));
+	entries[index] = *entry;
 }
 
-static void restack_xwayland_surface_below(struct sway_scene_node *node) {
+static void collect_xwayland_surfaces(struct sway_scene_node *node,
+		bool enabled, struct wl_array *visible, struct wl_array *hidden) {
+	enabled = enabled && node->enabled;
 	if (node->type == SWAY_SCENE_NODE_TREE) {
 		struct sway_scene_tree *scene_tree = sway_scene_tree_from_node(node);
 		struct sway_scene_node *child;
-		wl_list_for_each(child, &scene_tree->children, link) {
-			restack_xwayland_surface_below(child);
+		wl_list_for_each_reverse(child, &scene_tree->children, link) {
+			collect_xwayland_surfaces(child, enabled, visible, hidden);
 		}
 		return;
 	}
@@ -607,7 +690,106 @@ static void restack_xwayland_surface_below(struct sway_scene_node *node) {
 		return;
 	}
 
-	wlr_xwayland_surface_restack(xwayland_surface, NULL, XCB_STACK_MODE_BELOW);
+	struct xwayland_stack_entry entry = {
+		.surface = xwayland_surface,
+		.window_id = xwayland_surface->window_id,
+	};
+	if (xwayland_stack_find(visible, &entry) >= 0 ||
+			xwayland_stack_find(hidden, &entry) >= 0) {
+		return;
+	}
+	struct xwayland_stack_entry *added =
+		wl_array_add(enabled ? visible : hidden, sizeof(*added));
+	if (added) {
+		*added = entry;
+	}
+}
+
+// Brings the X stacking order in line with the scene once per event loop
+// iteration. scene->xwayland_stack holds the order last sent to the X server,
+// so only surfaces that are out of place get a restack request.
+static void handle_xwayland_restack_idle(void *data) {
+	struct sway_scene *scene = data;
+	scene->xwayland_restack_idle = NULL;
+	trace_begin("xwayland_restack", NULL);
+
+	struct wl_array visible, hidden;
+	wl_array_init(&visible);
+	wl_array_init(&hidden);
+	collect_xwayland_surfaces(&scene->tree.node, true, &visible, &hidden);
+
+	// Forget surfaces that left the scene
+	struct wl_array *stack = &scene->xwayland_stack;
+	struct xwayland_stack_entry *entries = stack->data;
+	size_t length = stack->size / sizeof(*entries);
+	size_t kept = 0;
+	for (size_t i = 0; i < length; i++) {
+		if (xwayland_stack_find(&visible, &entries[i]) >= 0 ||
+				xwayland_stack_find(&hidden, &entries[i]) >= 0) {
+			entries[kept++] = entries[i];
+		}
+	}
+	stack->size = kept * sizeof(*entries);
+
+	// Once the first i visible surfaces are in place, the next one only needs
+	// a request if it isn't already right below them.
+	size_t i = 0;
+	struct xwayland_stack_entry *entry;
+	wl_array_for_each(entry, &visible) {
+		entries = stack->data;
+		length = stack->size / sizeof(*entries);
+		if (i < length && entries[i].surface == entry->surface &&
+				entries[i].window_id == entry->window_id) {
+			i++;
+			continue;
+		}
+
+		if (i == 0) {
+			wlr_xwayland_surface_restack(entry->surface, NULL, XCB_STACK_MODE_ABOVE);
+		} else {
+			wlr_xwayland_surface_restack(entry->surface, entries[i - 1].surface,
+				XCB_STACK_MODE_BELOW);
+		}
+		xwayland_stack_move(stack, entry, i);
+		i++;
+	}
+
+	// Hidden surfaces only have to be below the visible ones, which the ones
+	// we already know are
+	wl_array_for_each(entry, &hidden) {
+		if (xwayland_stack_find(stack, entry) >= 0) {
+			continue;
+		}
+		wlr_xwayland_surface_restack(entry->surface, NULL, XCB_STACK_MODE_BELOW);
+		xwayland_stack_move(stack, entry, stack->size / sizeof(*entry));
+	}
+
+	wl_array_release(&visible);
+	wl_array_release(&hidden);
+	trace_end();
+}
+
+static void scene_schedule_xwayland_restack(struct sway_scene *scene) {
+	if (scene->xwayland_restack_idle) {
+		return;
+	}
+	scene->xwayland_restack_idle = wl_event_loop_add_idle(server.wl_event_loop,
+		handle_xwayland_restack_idle, scene);
+}
+
+static bool scene_node_has_managed_xwayland_surface(struct sway_scene_node *node) {
+	if (node->type == SWAY_SCENE_NODE_TREE) {
+		struct sway_scene_tree *scene_tree = sway_scene_tree_from_node(node);
+		struct sway_scene_node *child;
+		wl_list_for_each(child, &scene_tree->children, link) {
+			if (scene_node_has_managed_xwayland_surface(child)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	return scene_node_try_get_managed_xwayland_surface(node) != NULL;
 }
 #endif
 
@@ -662,6 +844,23 @@ static bool scene_node_get_background(struct sway_scene_node *node) {
 	return false;
 }
 
+static bool scene_node_get_blur_source(struct sway_scene_node *node) {
+	struct sway_scene_tree *tree;
+	if (node->type == SWAY_SCENE_NODE_TREE) {
+		tree = sway_scene_tree_from_node(node);
+	} else {
+		tree = node->parent;
+	}
+
+	while (tree != NULL) {
+		if (tree->node.info.blur_source) {
+			return true;
+		}
+		tree = tree->node.parent;
+	}
+	return false;
+}
+
 static void scene_node_apply_tiling_visibility(struct sway_scene_node *node,
 		struct wl_list *outputs) {
 	struct wlr_output *wlr_output = scene_node_get_output(node);
@@ -715,7 +914,9 @@ static bool scene_node_update_iterator(struct sway_scene_node *node,
 
 	update_node_update_outputs(node, data->outputs, NULL, NULL);
 #if WLR_HAS_XWAYLAND
-	restack_xwayland_surface(node, &box, data);
+	if (scene_node_try_get_managed_xwayland_surface(node)) {
+		data->restack_xwayland = true;
+	}
 #endif
 
 	return false;
@@ -781,6 +982,11 @@ static void scene_update_region(struct sway_scene *scene,
 
 	// update node visibility and output enter/leave events
 	scene_nodes_in_box(&scene->tree.node, &data.update_box, scene_node_update_iterator, &data);
+#if WLR_HAS_XWAYLAND
+	if (data.restack_xwayland) {
+		scene_schedule_xwayland_restack(scene);
+	}
+#endif
 
 	pixman_region32_fini(&visible);
 }
@@ -788,15 +994,19 @@ static void scene_update_region(struct sway_scene *scene,
 static void scene_node_update(struct sway_scene_node *node,
 		pixman_region32_t *damage) {
 	struct sway_scene *scene = scene_node_get_root(node);
+	bool blur_source = scene_node_get_blur_source(node);
 
 	double x, y;
 	if (!sway_scene_node_coords(node, &x, &y)) {
 #if WLR_HAS_XWAYLAND
-		restack_xwayland_surface_below(node);
+		if (scene_node_has_managed_xwayland_surface(node)) {
+			scene_schedule_xwayland_restack(scene);
+		}
 #endif
 		if (damage) {
 			scene_update_region(scene, damage);
-			scene_damage_outputs(scene, damage);
+			damage_heatmap_record_source(node, damage, 1.0);
+			scene_damage_outputs(scene, node, damage, blur_source);
 			pixman_region32_fini(damage);
 		}
 
@@ -819,7 +1029,8 @@ static void scene_node_update(struct sway_scene_node *node,
 	pixman_region32_fini(&update_region);
 
 	scene_node_visibility(node, damage);
-	scene_damage_outputs(scene, damage);
+	damage_heatmap_record_source(node, damage, 1.0);
+	scene_damage_outputs(scene, node, damage, blur_source);
 	pixman_region32_fini(damage);
 }
 
@@ -931,10 +1142,16 @@ static void scene_buffer_handle_renderer_destroy(struct wl_listener *listener,
 static void scene_buffer_set_texture(struct sway_scene_buffer *scene_buffer,
 		struct wlr_texture *texture) {
 	wl_list_remove(&scene_buffer->renderer_destroy.link);
+	if (scene_buffer->texture != NULL) {
+		mem_account_free(MEM_TEXTURE, (size_t)scene_buffer->texture->width *
+			scene_buffer->texture->height * 4);
+	}
 	wlr_texture_destroy(scene_buffer->texture);
 	scene_buffer->texture = texture;
 
 	if (texture != NULL) {
+		// Assume 4 bytes per pixel, good enough for accounting
+		mem_account_alloc(MEM_TEXTURE, (size_t)texture->width * texture->height * 4);
 		scene_buffer->renderer_destroy.notify = scene_buffer_handle_renderer_destroy;
 		wl_signal_add(&texture->renderer->events.destroy, &scene_buffer->renderer_destroy);
 	} else {
@@ -1082,8 +1299,11 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 	pixman_region32_intersect_rect(&trans_damage, &trans_damage,
 		box.x, box.y, box.width, box.height);
 	pixman_region32_translate(&trans_damage, -box.x, -box.y);
+	damage_heatmap_record_source(&scene_buffer->node, &trans_damage,
+		scale_x * scale_y);
 
 	struct sway_scene *scene = scene_node_get_root(&scene_buffer->node);
+	bool blur_source = scene_node_get_blur_source(&scene_buffer->node);
 	struct sway_scene_output *scene_output;
 	wl_list_for_each(scene_output, &scene->outputs, link) {
 		double output_scale = scene_output->output->scale;
@@ -1126,6 +1346,10 @@ void sway_scene_buffer_set_buffer_with_options(struct sway_scene_buffer *scene_b
 			round((ly - scene_output->y) * output_scale));
 		output_to_buffer_coords(&output_damage, scene_output->output);
 		scene_output_damage(scene_output, &output_damage);
+		if (blur_source) {
+			scene_output_damage_blur(scene_output, &scene_buffer->node,
+				&output_damage);
+		}
 		pixman_region32_fini(&output_damage);
 	}
 
@@ -1166,6 +1390,24 @@ void sway_scene_buffer_set_opaque_region(struct sway_scene_buffer *scene_buffer,
 	pixman_region32_fini(&update_region);
 }
 
+void sway_scene_buffer_get_translucent_region(struct sway_scene_buffer *scene_buffer,
+		pixman_region32_t *region) {
+	pixman_region32_copy(region, &scene_buffer->node.visible);
+
+	double x, y;
+	if (!sway_scene_node_coords(&scene_buffer->node, &x, &y)) {
+		pixman_region32_fini(region);
+		pixman_region32_init(region);
+		return;
+	}
+
+	pixman_region32_t opaque;
+	pixman_region32_init(&opaque);
+	scene_node_opaque_region(&scene_buffer->node, round(x), round(y), &opaque);
+	pixman_region32_subtract(region, region, &opaque);
+	pixman_region32_fini(&opaque);
+}
+
 void sway_scene_buffer_set_source_box(struct sway_scene_buffer *scene_buffer,
 		const struct wlr_fbox *box) {
 	if (wlr_fbox_equal(&scene_buffer->src_box, box)) {
@@ -1531,8 +1773,13 @@ struct render_list_entry {
 	double x, y;
 };
 
-static void scene_entry_render(struct render_list_entry *entry, const struct render_data *data) {
+// If pixels is not NULL, it is set to the rendered area in buffer pixels
+static void scene_entry_render(struct render_list_entry *entry, const struct render_data *data,
+		int64_t *pixels) {
 	struct sway_scene_node *node = entry->node;
+	if (pixels) {
+		*pixels = 0;
+	}
 
 	struct sway_workspace *workspace = scene_node_get_workspace(node);
 	double scale = workspace ? workspace->layout.workspaces.scale : 1.0;
@@ -1556,6 +1803,9 @@ static void scene_entry_render(struct render_list_entry *entry, const struct ren
 		pixman_region32_fini(&render_region);
 		return;
 	}
+	if (pixels) {
+		*pixels = region_area(&render_region);
+	}
 	double x = entry->x - data->logical.x;
 	double y = entry->y - data->logical.y;
 
@@ -1769,6 +2019,11 @@ static void scene_output_update_geometry(struct sway_scene_output *scene_output,
 		bool force_update) {
 	scene_output_damage_whole(scene_output);
 
+	// The cached blurred background no longer matches the output geometry
+	struct wlr_output *output = scene_output->output;
+	pixman_region32_union_rect(&scene_output->blur_damage,
+		&scene_output->blur_damage, 0, 0, output->width, output->height);
+
 	scene_node_output_update(&scene_output->scene->tree.node,
 			&scene_output->scene->outputs, NULL, force_update ? scene_output : NULL);
 }
@@ -1790,6 +2045,10 @@ static void scene_output_handle_commit(struct wl_listener *listener, void *data)
 			pixman_region32_fini(&scene_output->pending_commit_damage);
 			pixman_region32_init(&scene_output->pending_commit_damage);
 		}
+
+		// the blur cache has been refreshed with this frame
+		pixman_region32_fini(&scene_output->blur_damage);
+		pixman_region32_init(&scene_output->blur_damage);
 	}
 
 	bool force_update = state->committed & (
@@ -1852,6 +2111,7 @@ struct sway_scene_output *sway_scene_output_create(struct sway_scene *scene,
 
 	wlr_damage_ring_init(&scene_output->damage_ring);
 	pixman_region32_init(&scene_output->pending_commit_damage);
+	pixman_region32_init(&scene_output->blur_damage);
 	wl_list_init(&scene_output->damage_highlight_regions);
 
 	int prev_output_index = -1;
@@ -1922,6 +2182,7 @@ void sway_scene_output_destroy(struct sway_scene_output *scene_output) {
 	wlr_addon_finish(&scene_output->addon);
 	wlr_damage_ring_finish(&scene_output->damage_ring);
 	pixman_region32_fini(&scene_output->pending_commit_damage);
+	pixman_region32_fini(&scene_output->blur_damage);
 	wl_list_remove(&scene_output->link);
 	wl_list_remove(&scene_output->output_commit.link);
 	wl_list_remove(&scene_output->output_damage.link);
@@ -2206,6 +2467,14 @@ bool sway_scene_output_needs_frame(struct sway_scene_output *scene_output) {
 		scene_output->gamma_lut_changed;
 }
 
+const pixman_region32_t *sway_scene_output_get_blur_damage(
+		struct sway_scene_output *scene_output) {
+	if (pixman_region32_empty(&scene_output->blur_damage)) {
+		return NULL;
+	}
+	return &scene_output->blur_damage;
+}
+
 bool sway_scene_output_commit(struct sway_scene_output *scene_output,
 		const struct sway_scene_output_state_options *options) {
 	if (!sway_scene_output_needs_frame(scene_output)) {
@@ -2324,13 +2593,16 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 		.fractional_scale = floor(render_data.scale) != render_data.scale,
 	};
 
+	trace_begin("render_list", output->name);
 	list_con.render_list->size = 0;
 	scene_nodes_in_box(&scene_output->scene->tree.node, &list_con.box,
 		construct_render_list_iterator, &list_con);
 	array_realloc(list_con.render_list, list_con.render_list->size);
+	trace_end();
 
 	struct render_list_entry *list_data = list_con.render_list->data;
 	int list_len = list_con.render_list->size / sizeof(*list_data);
+	scene_output->stats.render_list_len = list_len;
 
 	if (debug_damage == SWAY_SCENE_DEBUG_DAMAGE_RERENDER) {
 		scene_output_damage_whole(scene_output);
@@ -2376,6 +2648,19 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 
 	wlr_output_state_set_damage(state, &scene_output->pending_commit_damage);
 
+	int64_t damaged_area = 0;
+	int nrects;
+	const pixman_box32_t *rects =
+		pixman_region32_rectangles(&scene_output->pending_commit_damage, &nrects);
+	for (int i = 0; i < nrects; ++i) {
+		damaged_area += (int64_t)(rects[i].x2 - rects[i].x1) *
+			(rects[i].y2 - rects[i].y1);
+	}
+	scene_output->stats.damaged_area = damaged_area;
+	scene_output->stats.damage_extents =
+		*pixman_region32_extents(&scene_output->pending_commit_damage);
+	damage_heatmap_record_frame(output, &scene_output->pending_commit_damage);
+
 	// We only want to try direct scanout if:
 	// - There is only one entry in the render list
 	// - There are no color transforms that need to be applied
@@ -2406,6 +2691,8 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 
 	if (scanout) {
 		scene_output_state_attempt_gamma(scene_output, state);
+		scene_output->stats.frames++;
+		scene_output->stats.direct_scanouts++;
 
 		if (timer) {
 			struct timespec end_time, duration;
@@ -2514,9 +2801,23 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 	});
 	pixman_region32_fini(&background);
 
+	bool profiling = render_profile_frame_begin(output);
 	for (int i = list_len - 1; i >= 0; i--) {
 		struct render_list_entry *entry = &list_data[i];
-		scene_entry_render(entry, &render_data);
+		trace_begin("scene_entry_render", NULL);
+		if (profiling) {
+			struct timespec entry_start, entry_end, entry_duration;
+			int64_t pixels;
+			clock_gettime(CLOCK_MONOTONIC, &entry_start);
+			scene_entry_render(entry, &render_data, &pixels);
+			clock_gettime(CLOCK_MONOTONIC, &entry_end);
+			timespec_sub(&entry_duration, &entry_end, &entry_start);
+			render_profile_record_entry(output, entry->node,
+				timespec_to_nsec(&entry_duration), pixels);
+		} else {
+			scene_entry_render(entry, &render_data, NULL);
+		}
+		trace_end();
 
 		if (entry->node->type == SWAY_SCENE_NODE_BUFFER) {
 			struct sway_scene_buffer *buffer = sway_scene_buffer_from_node(entry->node);
@@ -2555,7 +2856,10 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 	wlr_output_add_software_cursors_to_render_pass(output, render_pass, &render_data.damage);
 	pixman_region32_fini(&render_data.damage);
 
-	if (!wlr_render_pass_submit(render_pass)) {
+	trace_begin("render_pass_submit", output->name);
+	bool submitted = wlr_render_pass_submit(render_pass);
+	trace_end();
+	if (!submitted) {
 		wlr_buffer_unlock(buffer);
 
 		// if we failed to render the buffer, it will have undefined contents
@@ -2566,6 +2870,10 @@ bool sway_scene_output_build_state(struct sway_scene_output *scene_output,
 
 	wlr_output_state_set_buffer(state, buffer);
 	wlr_buffer_unlock(buffer);
+	scene_output->stats.frames++;
+	if (profiling) {
+		render_profile_frame_end(output);
+	}
 
 	if (scene_output->in_timeline != NULL) {
 		wlr_output_state_set_wait_timeline(state, scene_output->in_timeline,
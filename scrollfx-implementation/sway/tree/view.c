@@ -19,6 +19,7 @@
 #include "list.h"
 #include "log.h"
 #include "sway/criteria.h"
+#include "sway/criteria_index.h"
 #include "sway/commands.h"
 #include "sway/desktop/transaction.h"
 #include "sway/desktop/idle_inhibit_v1.h"
@@ -27,11 +28,14 @@
 #include "sway/ipc-server.h"
 #include "sway/output.h"
 #include "sway/input/seat.h"
+#include "sway/mem_stats.h"
+#include "sway/replay.h"
 #include "sway/scene_descriptor.h"
 #include "sway/server.h"
 #include "sway/sway_text_node.h"
 #include "sway/tree/arrange.h"
 #include "sway/tree/container.h"
+#include "sway/tree/root.h"
 #include "sway/tree/view.h"
 #include "sway/tree/workspace.h"
 #include "sway/tree/scene.h"
@@ -755,6 +759,8 @@ void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 	view->surface = wlr_surface;
 	view_populate_pid(view);
 	view->container = container_create(view);
+	criteria_index_add_view(view);
+	root_index_add_view(view);
 
 	if (view->ctx == NULL) {
 		struct launcher_ctx *ctx = launcher_ctx_find_pid(view->pid);
@@ -911,6 +917,8 @@ void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 		wlr_foreign_toplevel_handle_v1_set_app_id(view->foreign_toplevel, class);
 	}
 
+	replay_record_view_map(view);
+
 	// Lua callbacks
 	for (int i = 0; i < config->lua.cbs_view_map->length; ++i) {
 		struct sway_lua_closure *closure = config->lua.cbs_view_map->items[i];
@@ -924,6 +932,8 @@ void view_map(struct sway_view *view, struct wlr_surface *wlr_surface,
 }
 
 void view_unmap(struct sway_view *view) {
+	replay_record_view_unmap(view);
+
 	// Lua callbacks
 	for (int i = 0; i < config->lua.cbs_view_unmap->length; ++i) {
 		struct sway_lua_closure *closure = config->lua.cbs_view_unmap->items[i];
@@ -953,6 +963,8 @@ void view_unmap(struct sway_view *view) {
 	}
 
 	layout_trail_remove_view(view);
+	criteria_index_remove_view(view);
+	root_index_remove_view(view);
 
 	struct sway_container *parent = view->container->pending.parent;
 	struct sway_workspace *ws = view->container->pending.workspace;
@@ -1064,6 +1076,8 @@ struct sway_view *view_from_wlr_surface(struct wlr_surface *wlr_surface) {
 void view_update_app_id(struct sway_view *view) {
 	const char *app_id = view_get_app_id(view);
 
+	criteria_index_update_view(view);
+
 	if (view->foreign_toplevel && app_id) {
 		wlr_foreign_toplevel_handle_v1_set_app_id(view->foreign_toplevel, app_id);
 	}
@@ -1197,11 +1211,30 @@ bool view_is_urgent(struct sway_view *view) {
 	return view->urgent.tv_sec || view->urgent.tv_nsec;
 }
 
+static void view_saved_buffer_size_iterator(struct sway_scene_buffer *buffer,
+		int sx, int sy, void *data) {
+	size_t *bytes = data;
+	if (buffer->buffer) {
+		*bytes += (size_t)buffer->buffer->width * buffer->buffer->height * 4;
+	}
+}
+
+// Saved buffers keep the client's buffers alive after it has moved on
+static size_t view_saved_buffer_size(struct sway_view *view) {
+	size_t bytes = 0;
+	sway_scene_node_for_each_buffer(&view->saved_surface_tree->node,
+		view_saved_buffer_size_iterator, &bytes);
+	return bytes;
+}
+
 void view_remove_saved_buffer(struct sway_view *view) {
 	if (!sway_assert(view->saved_surface_tree, "Expected a saved buffer")) {
 		return;
 	}
 
+	// The buffers are unlocked once uploaded, so free what was accounted
+	mem_account_free(MEM_SAVED_BUFFER, view->saved_buffer_bytes);
+	view->saved_buffer_bytes = 0;
 	sway_scene_node_destroy(&view->saved_surface_tree->node);
 	view->saved_surface_tree = NULL;
 	sway_scene_node_set_enabled(&view->content_tree->node, true);
@@ -1261,6 +1294,8 @@ void view_save_buffer(struct sway_view *view) {
 
 	sway_scene_node_for_each_buffer(&view->content_tree->node,
 		view_save_buffer_iterator, view->saved_surface_tree);
+	view->saved_buffer_bytes = view_saved_buffer_size(view);
+	mem_account_alloc(MEM_SAVED_BUFFER, view->saved_buffer_bytes);
 
 	sway_scene_node_set_enabled(&view->content_tree->node, false);
 	sway_scene_node_set_enabled(&view->saved_surface_tree->node, true);